@@ -0,0 +1,207 @@
+// Microbenchmarks for the hot CPU paths. Each bench runs a fixed iteration
+// count and prints one CSV row (name,iters,ns_per_op) on stdout so CI can
+// diff runs; skipped benches print a comment line instead.
+
+#include "base/pai_device.hpp"
+#include "base/pai_window.hpp"
+#include "pai_game_object.hpp"
+#include "pai_model.hpp"
+#include "pai_pixel.hpp"
+#include "pai_world.hpp"
+
+// std
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+    volatile float sink = 0.f; // keeps results observable so the loops aren't elided
+
+    void runBench(const std::string &name, uint64_t iters, const std::function<void()> &op)
+    {
+        op(); // warmup
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            op();
+        }
+        auto end = std::chrono::steady_clock::now();
+        double nsPerOp =
+            std::chrono::duration<double, std::nano>(end - start).count() / iters;
+        std::cout << name << "," << iters << "," << nsPerOp << "\n";
+    }
+
+    void benchWorldActions(int size, uint64_t iters)
+    {
+        pai::PaiWorld world{size, size};
+        int x = 0;
+        int y = 0;
+        runBench(
+            "world_actions_" + std::to_string(size),
+            iters,
+            [&]()
+            {
+                auto actions = world.actions(glm::vec2(x, y));
+                sink = sink + actions.x + actions.y + actions.z + actions.w;
+                y = (y + 1) % size;
+                x = y == 0 ? (x + 1) % size : x;
+            });
+    }
+
+    void benchWorldActionsBatched(int size, size_t agentCount, uint64_t iters)
+    {
+        pai::PaiWorld world{size, size};
+        std::vector<glm::ivec2> agents(agentCount);
+        for (size_t i = 0; i < agentCount; i++)
+        {
+            agents[i] = {static_cast<int>(i) % size, static_cast<int>(i / size) % size};
+        }
+        std::vector<glm::vec4> out;
+        runBench(
+            "world_actions_batched_" + std::to_string(size) + "x" + std::to_string(agentCount),
+            iters,
+            [&]()
+            {
+                world.actions(agents, out);
+                sink = sink + out.back().x;
+            });
+    }
+
+    void benchWorldAddStatesBulk(int size, size_t cellCount, uint64_t iters)
+    {
+        pai::PaiWorld world{size, size};
+        std::vector<glm::vec2> cells(cellCount);
+        for (size_t i = 0; i < cellCount; i++)
+        {
+            cells[i] = {static_cast<int>(i) % size, static_cast<int>(i / size) % size};
+        }
+        runBench(
+            "world_add_states_bulk_" + std::to_string(cellCount),
+            iters,
+            [&]() { world.addStates(cells, 1); });
+    }
+
+    void benchTransformMat4(size_t objectCount, uint64_t iters)
+    {
+        std::vector<pai::TransformComponent> transforms(objectCount);
+        for (size_t i = 0; i < objectCount; i++)
+        {
+            transforms[i].translation = {static_cast<float>(i), 0.f, 1.f};
+            transforms[i].rotation = {0.1f * i, 0.2f * i, 0.3f * i};
+        }
+        runBench(
+            "transform_mat4_bulk_" + std::to_string(objectCount),
+            iters,
+            [&]()
+            {
+                float total = 0.f;
+                for (auto &transform : transforms)
+                {
+                    total += transform.mat4()[3][0];
+                }
+                sink = sink + total;
+            });
+    }
+
+    // a shared-vertex quad grid, so the dedup path actually merges vertices
+    std::string writeBenchObj(int gridSize)
+    {
+        auto path = (std::filesystem::temp_directory_path() / "pai_bench.obj").string();
+        std::ofstream file{path, std::ios::trunc};
+        for (int i = 0; i <= gridSize; i++)
+        {
+            for (int j = 0; j <= gridSize; j++)
+            {
+                file << "v " << i << " " << j << " 0\n";
+            }
+        }
+        for (int i = 0; i < gridSize; i++)
+        {
+            for (int j = 0; j < gridSize; j++)
+            {
+                int v0 = i * (gridSize + 1) + j + 1; // obj indices are one-based
+                int v1 = v0 + 1;
+                int v2 = v0 + gridSize + 1;
+                int v3 = v2 + 1;
+                file << "f " << v0 << " " << v1 << " " << v3 << " " << v2 << "\n";
+            }
+        }
+        return path;
+    }
+
+    void benchModelLoad(uint64_t iters)
+    {
+        auto objPath = writeBenchObj(100);
+        runBench(
+            "model_load_obj_parse_dedup",
+            iters,
+            [&]()
+            {
+                // drop the mesh cache so every iteration takes the parse path
+                std::error_code ec;
+                std::filesystem::remove(objPath + ".pmesh", ec);
+                pai::PaiModel::Builder builder{};
+                builder.loadModel(objPath);
+                sink = sink + static_cast<float>(builder.vertices.size());
+            });
+        std::error_code ec;
+        std::filesystem::remove(objPath, ec);
+        std::filesystem::remove(objPath + ".pmesh", ec);
+    }
+
+    void benchPixelAddState(uint64_t iters)
+    {
+        try
+        {
+            pai::PaiWindow window{64, 64, "PaiBench", false};
+            pai::PaiDevice device{window};
+            {
+                pai::PaiPixel pixel{device, 24, 24, {}};
+                glm::vec2 state{0.f, 0.f};
+                runBench(
+                    "pixel_add_state_upload",
+                    iters,
+                    [&]()
+                    {
+                        pixel.addState(state);
+                        // uploads are deferred to the frame command buffer; stand in
+                        // with a synchronous one-shot so the copy cost is measured
+                        auto commandBuffer = device.beginSingleTimeCommands();
+                        pixel.flushPending(commandBuffer, 0);
+                        device.endSingleTimeCommands(commandBuffer);
+                        state.y = state.y + 1.f > 23.f ? 0.f : state.y + 1.f;
+                        state.x = state.y == 0.f ? (state.x + 1.f > 23.f ? 0.f : state.x + 1.f)
+                                                 : state.x;
+                    });
+                vkDeviceWaitIdle(device.device());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "# pixel_add_state_upload skipped: " << e.what() << "\n";
+        }
+    }
+
+}
+
+int main()
+{
+    std::cout << "name,iters,ns_per_op\n";
+
+    benchWorldActions(24, 1000000);
+    benchWorldActions(256, 1000000);
+    benchWorldActions(2048, 1000000);
+    benchWorldActionsBatched(2048, 1024, 10000);
+    benchWorldAddStatesBulk(2048, 4096, 10000);
+    benchTransformMat4(10000, 1000);
+    benchModelLoad(5);
+    benchPixelAddState(10000);
+
+    return 0;
+}
@@ -9,6 +9,11 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     vec2 agent;
 } ubo;
 
+// one flag per cell in vertex-buffer order; nonzero marks an occupied cell
+layout(std430, set = 0, binding = 1) readonly buffer AgentGrid {
+    uint flags[];
+} agentGrid;
+
 layout(push_constant) uniform Push {
     vec4 color;
     float size;
@@ -17,7 +22,7 @@ layout(push_constant) uniform Push {
 void main() {
     gl_Position = vec4(position.x, position.y, 0.0, 1.0);
     gl_PointSize = 1.0;
-    if(position.z == ubo.agent.x && position.w == ubo.agent.y) {
+    if(agentGrid.flags[gl_VertexIndex] != 0) {
         cellColor = vec4(0.5f, 0.3f, 0.2f, 0.5f);
     } else {
         if(state.x == 1.0f)
@@ -0,0 +1,45 @@
+#version 460
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 state;
+
+layout(location = 0) out vec4 cellColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    vec2 agent;
+} ubo;
+
+// one flag per cell, laid out like the shared vertex buffer, so the
+// per-grid firstInstance offset indexes it too
+layout(std430, set = 0, binding = 1) readonly buffer AgentGrid {
+    uint flags[];
+} agentGrid;
+
+struct PixelDrawData {
+    vec4 color;
+    vec4 size; // x is the cell size, rest is padding
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer DrawDataBuffer {
+    PixelDrawData draws[];
+} drawData;
+
+void main() {
+    // one indirect draw per grid; per-grid color and size come from the draw-data
+    // buffer indexed by gl_DrawID instead of push constants
+    PixelDrawData draw = drawData.draws[gl_DrawID];
+    vec2 corner = vec2(gl_VertexIndex >> 1, gl_VertexIndex & 1);
+    gl_Position = vec4(position.xy + corner * draw.size.x, 0.0, 1.0);
+    if(agentGrid.flags[gl_InstanceIndex] != 0) {
+        cellColor = vec4(0.5f, 0.3f, 0.2f, 0.5f);
+    } else {
+        if(state.x == 1.0f)
+        {
+            cellColor = vec4(0.f, 0.f, 0.f, 0.5f);
+        }
+        else
+        {
+            cellColor = draw.color;
+        }
+    }
+}
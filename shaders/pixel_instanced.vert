@@ -0,0 +1,42 @@
+#version 450
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 state;
+
+layout(location = 0) out vec4 cellColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    vec2 agent;
+} ubo;
+
+// one flag per cell in vertex-buffer order; nonzero marks an occupied cell
+layout(std430, set = 0, binding = 1) readonly buffer AgentGrid {
+    uint flags[];
+} agentGrid;
+
+layout(push_constant) uniform Push {
+    vec4 color;
+    float size;
+} push;
+
+// baked per grid through a pipeline variant; the default matches the 24x24 grid
+layout(constant_id = 0) const float CELL_SIZE = 0.08333334;
+
+void main() {
+    // one instance per cell; the quad corners come from gl_VertexIndex in the
+    // same strip order the geometry shader used to emit
+    vec2 corner = vec2(gl_VertexIndex >> 1, gl_VertexIndex & 1);
+    gl_Position = vec4(position.xy + corner * CELL_SIZE, 0.0, 1.0);
+    if(agentGrid.flags[gl_InstanceIndex] != 0) {
+        cellColor = vec4(0.5f, 0.3f, 0.2f, 0.5f);
+    } else {
+        if(state.x == 1.0f)
+        {
+            cellColor = vec4(0.f, 0.f, 0.f, 0.5f);
+        }
+        else
+        {
+            cellColor =  push.color;
+        }
+    }
+}
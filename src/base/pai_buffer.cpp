@@ -47,14 +47,14 @@ namespace pai
     {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     PaiBuffer::~PaiBuffer()
     {
         unmap();
         vkDestroyBuffer(paiDevice.device(), buffer, nullptr);
-        vkFreeMemory(paiDevice.device(), memory, nullptr);
+        paiDevice.freeMemory(allocation);
     }
 
     /**
@@ -68,22 +68,24 @@ namespace pai
      */
     VkResult PaiBuffer::map(VkDeviceSize size, VkDeviceSize offset)
     {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(paiDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.memory && "Called map on buffer before create");
+        if (allocation.mapped == nullptr)
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        // the owning memory block is persistently mapped, so mapping is just pointer math
+        mapped = static_cast<char *>(allocation.mapped) + allocation.offset + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The owning block stays mapped, only this buffer's view is dropped
      */
     void PaiBuffer::unmap()
     {
-        if (mapped)
-        {
-            vkUnmapMemory(paiDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -126,8 +128,8 @@ namespace pai
     {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = allocation.offset + offset;
         mappedRange.size = size;
         return vkFlushMappedMemoryRanges(paiDevice.device(), 1, &mappedRange);
     }
@@ -147,8 +149,8 @@ namespace pai
     {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = allocation.offset + offset;
         mappedRange.size = size;
         return vkInvalidateMappedMemoryRanges(paiDevice.device(), 1, &mappedRange);
     }
@@ -1,12 +1,41 @@
 #include "pai_descriptors.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
 
 namespace pai
 {
 
+    namespace
+    {
+        // layouts with identical binding contents share one VkDescriptorSetLayout;
+        // entries are refcounted and destroyed with the last PaiDescriptorSetLayout
+        struct LayoutCacheEntry
+        {
+            VkDescriptorSetLayout layout;
+            uint32_t refCount;
+        };
+        std::unordered_map<std::string, LayoutCacheEntry> layoutCache;
+        std::mutex layoutCacheMutex;
+
+        std::string layoutCacheKey(
+            VkDevice device, const std::vector<VkDescriptorSetLayoutBinding> &bindings)
+        {
+            std::string key;
+            key.resize(sizeof(device) + bindings.size() * sizeof(VkDescriptorSetLayoutBinding));
+            std::memcpy(key.data(), &device, sizeof(device));
+            std::memcpy(
+                key.data() + sizeof(device),
+                bindings.data(),
+                bindings.size() * sizeof(VkDescriptorSetLayoutBinding));
+            return key;
+        }
+    }
+
     // *************** Descriptor Set Layout Builder *********************
 
     PaiDescriptorSetLayout::Builder &PaiDescriptorSetLayout::Builder::addBinding(
@@ -41,6 +70,24 @@ namespace pai
         {
             setLayoutBindings.push_back(kv.second);
         }
+        // deterministic order so equal binding sets produce equal cache keys
+        std::sort(
+            setLayoutBindings.begin(),
+            setLayoutBindings.end(),
+            [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+            { return a.binding < b.binding; });
+
+        cacheKey = layoutCacheKey(paiDevice.device(), setLayoutBindings);
+        {
+            std::lock_guard<std::mutex> lock{layoutCacheMutex};
+            auto cached = layoutCache.find(cacheKey);
+            if (cached != layoutCache.end())
+            {
+                cached->second.refCount++;
+                descriptorSetLayout = cached->second.layout;
+                return;
+            }
+        }
 
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -55,11 +102,29 @@ namespace pai
         {
             throw std::runtime_error("failed to create descriptor set layout!");
         }
+
+        std::lock_guard<std::mutex> lock{layoutCacheMutex};
+        auto cached = layoutCache.find(cacheKey);
+        if (cached != layoutCache.end())
+        {
+            // another thread built the same layout in the meantime, keep theirs
+            vkDestroyDescriptorSetLayout(paiDevice.device(), descriptorSetLayout, nullptr);
+            cached->second.refCount++;
+            descriptorSetLayout = cached->second.layout;
+            return;
+        }
+        layoutCache[cacheKey] = {descriptorSetLayout, 1};
     }
 
     PaiDescriptorSetLayout::~PaiDescriptorSetLayout()
     {
-        vkDestroyDescriptorSetLayout(paiDevice.device(), descriptorSetLayout, nullptr);
+        std::lock_guard<std::mutex> lock{layoutCacheMutex};
+        auto cached = layoutCache.find(cacheKey);
+        if (cached != layoutCache.end() && --cached->second.refCount == 0)
+        {
+            layoutCache.erase(cached);
+            vkDestroyDescriptorSetLayout(paiDevice.device(), descriptorSetLayout, nullptr);
+        }
     }
 
     // *************** Descriptor Pool Builder *********************
@@ -95,7 +160,29 @@ namespace pai
         uint32_t maxSets,
         VkDescriptorPoolCreateFlags poolFlags,
         const std::vector<VkDescriptorPoolSize> &poolSizes)
-        : paiDevice{paiDevice}
+        : paiDevice{paiDevice}, maxSets{maxSets}, poolFlags{poolFlags}, poolSizes{poolSizes}
+    {
+        if (this->poolSizes.empty())
+        {
+            // no pre-sizing required: a mixed ratio that covers the usual set shapes
+            this->poolSizes = {
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxSets * 2},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxSets * 2},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets},
+            };
+        }
+        pools.push_back(createPool());
+    }
+
+    PaiDescriptorPool::~PaiDescriptorPool()
+    {
+        for (auto pool : pools)
+        {
+            vkDestroyDescriptorPool(paiDevice.device(), pool, nullptr);
+        }
+    }
+
+    VkDescriptorPool PaiDescriptorPool::createPool()
     {
         VkDescriptorPoolCreateInfo descriptorPoolInfo{};
         descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -104,48 +191,67 @@ namespace pai
         descriptorPoolInfo.maxSets = maxSets;
         descriptorPoolInfo.flags = poolFlags;
 
-        if (vkCreateDescriptorPool(paiDevice.device(), &descriptorPoolInfo, nullptr, &descriptorPool) !=
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(paiDevice.device(), &descriptorPoolInfo, nullptr, &pool) !=
             VK_SUCCESS)
         {
             throw std::runtime_error("failed to create descriptor pool!");
         }
-    }
-
-    PaiDescriptorPool::~PaiDescriptorPool()
-    {
-        vkDestroyDescriptorPool(paiDevice.device(), descriptorPool, nullptr);
+        return pool;
     }
 
     bool PaiDescriptorPool::allocateDescriptor(
-        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const
+        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor)
     {
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorPool = pools.back();
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
-        if (vkAllocateDescriptorSets(paiDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS)
+        auto result = vkAllocateDescriptorSets(paiDevice.device(), &allocInfo, &descriptor);
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+        {
+            // current pool is spent, chain a fresh one and retry there
+            pools.push_back(createPool());
+            allocInfo.descriptorPool = pools.back();
+            result = vkAllocateDescriptorSets(paiDevice.device(), &allocInfo, &descriptor);
+        }
+        if (result != VK_SUCCESS)
         {
             return false;
         }
+        if (poolFlags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+        {
+            setOwner[descriptor] = allocInfo.descriptorPool;
+        }
         return true;
     }
 
-    void PaiDescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const
+    void PaiDescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors)
     {
-        vkFreeDescriptorSets(
-            paiDevice.device(),
-            descriptorPool,
-            static_cast<uint32_t>(descriptors.size()),
-            descriptors.data());
+        assert(
+            (poolFlags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) &&
+            "Pool was not built with the free descriptor set flag");
+        for (auto descriptor : descriptors)
+        {
+            auto owner = setOwner.find(descriptor);
+            if (owner == setOwner.end())
+            {
+                continue;
+            }
+            vkFreeDescriptorSets(paiDevice.device(), owner->second, 1, &descriptor);
+            setOwner.erase(owner);
+        }
     }
 
     void PaiDescriptorPool::resetPool()
     {
-        vkResetDescriptorPool(paiDevice.device(), descriptorPool, 0);
+        for (auto pool : pools)
+        {
+            vkResetDescriptorPool(paiDevice.device(), pool, 0);
+        }
+        setOwner.clear();
     }
 
     // *************** Descriptor Writer *********************
@@ -4,6 +4,7 @@
 
 // std
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -42,6 +43,7 @@ namespace pai
         PaiDevice &paiDevice;
         VkDescriptorSetLayout descriptorSetLayout;
         std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
+        std::string cacheKey; // handles are shared between layouts with equal bindings
 
         friend class PaiDescriptorWriter;
     };
@@ -75,16 +77,25 @@ namespace pai
         PaiDescriptorPool(const PaiDescriptorPool &) = delete;
         PaiDescriptorPool &operator=(const PaiDescriptorPool &) = delete;
 
+        // Allocates from the newest pool in the chain, chaining a fresh pool of the
+        // same shape when it runs out; only fails on a genuinely broken allocation
         bool allocateDescriptor(
-            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const;
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor);
 
-        void freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const;
+        // Requires VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+        void freeDescriptors(std::vector<VkDescriptorSet> &descriptors);
 
         void resetPool();
 
     private:
+        VkDescriptorPool createPool();
+
         PaiDevice &paiDevice;
-        VkDescriptorPool descriptorPool;
+        uint32_t maxSets;
+        VkDescriptorPoolCreateFlags poolFlags;
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        std::vector<VkDescriptorPool> pools; // allocations come from pools.back()
+        std::unordered_map<VkDescriptorSet, VkDescriptorPool> setOwner; // with the free flag only
 
         friend class PaiDescriptorWriter;
     };
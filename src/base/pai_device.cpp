@@ -2,13 +2,20 @@
 
 // std headers
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
 
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
+
 namespace pai
 {
 
+    static const char *PIPELINE_CACHE_PATH = ENGINE_DIR "pipeline_cache.bin";
+
     // local callback functions
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
         VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -63,11 +70,47 @@ namespace pai
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createTransferCommandPool();
+        createPipelineCache();
     }
 
     PaiDevice::~PaiDevice()
     {
+        // high-water log: what the run actually needed per heap, for sizing worlds
+        // and frames-in-flight buffering to the deployed card
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            if (heapUsage[i].highWaterBytes == 0)
+            {
+                continue;
+            }
+            std::cout << "memory heap " << i
+                      << ((memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                              ? " (device local)"
+                              : "")
+                      << ": peak " << heapUsage[i].highWaterBytes / (1024 * 1024) << " MiB of "
+                      << memoryProperties.memoryHeaps[i].size / (1024 * 1024) << " MiB" << std::endl;
+        }
+
+        savePipelineCache();
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+        for (auto &transfer : pendingTransfers)
+        {
+            vkWaitForFences(device_, 1, &transfer.fence, VK_TRUE, UINT64_MAX);
+            vkDestroyFence(device_, transfer.fence, nullptr);
+            vkFreeCommandBuffers(device_, transferCommandPool, 1, &transfer.commandBuffer);
+        }
+        pendingTransfers.clear();
+        vkDestroyCommandPool(device_, transferCommandPool, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
+        for (auto &kv : memoryPools)
+        {
+            for (auto &block : kv.second)
+            {
+                vkFreeMemory(device_, block.memory, nullptr);
+            }
+        }
+        memoryPools.clear();
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers)
@@ -92,7 +135,7 @@ namespace pai
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_1;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -174,6 +217,9 @@ namespace pai
 
         vkGetPhysicalDeviceProperties(physicalDevice, &properties);
         std::cout << "physical device: " << properties.deviceName << std::endl;
+
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        heapUsage.resize(memoryProperties.memoryHeapCount);
     }
 
     void PaiDevice::createLogicalDevice()
@@ -181,7 +227,8 @@ namespace pai
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        std::set<uint32_t> uniqueQueueFamilies = {
+            indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -197,16 +244,45 @@ namespace pai
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
         deviceFeatures.geometryShader = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = VK_TRUE;
+        deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+
+        // gl_DrawID in the batched pixel shader
+        VkPhysicalDeviceShaderDrawParametersFeatures drawParametersFeatures = {};
+        drawParametersFeatures.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES;
+        drawParametersFeatures.shaderDrawParameters = VK_TRUE;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &drawParametersFeatures;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+        // VK_EXT_memory_budget is optional: with it getMemoryBudget reports the
+        // driver's live budget and usage, without it only heap sizes and our own
+        // counters
+        std::vector<const char *> enabledExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        uint32_t availableExtensionCount;
+        vkEnumerateDeviceExtensionProperties(
+            physicalDevice, nullptr, &availableExtensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+        vkEnumerateDeviceExtensionProperties(
+            physicalDevice, nullptr, &availableExtensionCount, availableExtensions.data());
+        for (const auto &extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+            {
+                memoryBudgetSupported = true;
+                enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                break;
+            }
+        }
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -227,6 +303,7 @@ namespace pai
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
     }
 
     void PaiDevice::createCommandPool()
@@ -245,6 +322,73 @@ namespace pai
         }
     }
 
+    void PaiDevice::createTransferCommandPool()
+    {
+        QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily;
+        poolInfo.flags =
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create transfer command pool!");
+        }
+    }
+
+    void PaiDevice::createPipelineCache()
+    {
+        // seed the cache with last run's data so restarts skip shader compilation
+        std::vector<char> initialData;
+        std::ifstream file{PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary};
+        if (file.is_open())
+        {
+            size_t fileSize = (size_t)file.tellg();
+            initialData.resize(fileSize);
+            file.seekg(0);
+            file.read(initialData.data(), fileSize);
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.data();
+
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+        {
+            // a stale or corrupt cache file must never block startup
+            cacheInfo.initialDataSize = 0;
+            cacheInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+        }
+    }
+
+    void PaiDevice::savePipelineCache()
+    {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, nullptr) != VK_SUCCESS ||
+            dataSize == 0)
+        {
+            return;
+        }
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        std::ofstream file{PIPELINE_CACHE_PATH, std::ios::binary | std::ios::trunc};
+        if (file.is_open())
+        {
+            file.write(data.data(), dataSize);
+        }
+    }
+
     void PaiDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
 
     bool PaiDevice::isDeviceSuitable(VkPhysicalDevice device)
@@ -406,6 +550,13 @@ namespace pai
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
+            // prefer a transfer-only family so copies run beside graphics work
+            if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                indices.transferFamily = i;
+                indices.transferFamilyHasValue = true;
+            }
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
             if (queueFamily.queueCount > 0 && presentSupport)
@@ -413,7 +564,7 @@ namespace pai
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
             }
-            if (indices.isComplete())
+            if (indices.isComplete() && indices.transferFamilyHasValue)
             {
                 break;
             }
@@ -421,6 +572,12 @@ namespace pai
             i++;
         }
 
+        if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue)
+        {
+            indices.transferFamily = indices.graphicsFamily;
+            indices.transferFamilyHasValue = true;
+        }
+
         return indices;
     }
 
@@ -474,6 +631,20 @@ namespace pai
         throw std::runtime_error("failed to find supported format!");
     }
 
+    bool PaiDevice::hasMemoryType(VkMemoryPropertyFlags properties)
+    {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+        {
+            if ((memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     uint32_t PaiDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
     {
         VkPhysicalDeviceMemoryProperties memProperties;
@@ -495,7 +666,7 @@ namespace pai
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory)
+        MemoryAllocation &allocation)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -503,6 +674,17 @@ namespace pai
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+        // buffers touched by both the graphics and the dedicated transfer queue use
+        // concurrent sharing so copies need no ownership-transfer barriers
+        QueueFamilyIndices indices = findPhysicalQueueFamilies();
+        uint32_t queueFamilies[] = {indices.graphicsFamily, indices.transferFamily};
+        if (indices.transferFamily != indices.graphicsFamily)
+        {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = 2;
+            bufferInfo.pQueueFamilyIndices = queueFamilies;
+        }
+
         if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create vertex buffer!");
@@ -511,17 +693,269 @@ namespace pai
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
+        allocation = allocateMemory(memRequirements, properties);
+
+        vkBindBufferMemory(device_, buffer, allocation.memory, allocation.offset);
+    }
+
+    PaiDevice::MemoryBlock &PaiDevice::createMemoryBlock(uint32_t memoryTypeIndex, bool hostVisible)
+    {
         VkMemoryAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        allocInfo.allocationSize = MEMORY_BLOCK_SIZE;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        MemoryBlock block{};
+        block.id = nextBlockId++;
+        block.size = MEMORY_BLOCK_SIZE;
+        if (vkAllocateMemory(device_, &allocInfo, nullptr, &block.memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate memory block!");
+        }
+        trackHeapAllocation(heapIndexFor(memoryTypeIndex), block.size, false);
+
+        // host visible blocks stay persistently mapped, sub-allocations share the mapping
+        if (hostVisible)
+        {
+            vkMapMemory(device_, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped);
+        }
+        block.freeRanges.push_back({0, block.size});
+
+        auto &pool = memoryPools[memoryTypeIndex];
+        pool.push_back(block);
+        return pool.back();
+    }
+
+    bool PaiDevice::carveFromBlock(
+        MemoryBlock &block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation &allocation)
+    {
+        for (size_t i = 0; i < block.freeRanges.size(); i++)
+        {
+            MemoryRange &range = block.freeRanges[i];
+            VkDeviceSize alignedOffset = (range.offset + alignment - 1) & ~(alignment - 1);
+            VkDeviceSize padding = alignedOffset - range.offset;
+            if (padding + size > range.size)
+            {
+                continue;
+            }
+
+            allocation.memory = block.memory;
+            allocation.offset = alignedOffset;
+            allocation.size = size;
+            allocation.blockId = block.id;
+            if (block.mapped != nullptr)
+            {
+                allocation.mapped = block.mapped;
+            }
+
+            MemoryRange tail{alignedOffset + size, range.size - padding - size};
+            if (padding > 0)
+            {
+                range.size = padding;
+                if (tail.size > 0)
+                {
+                    block.freeRanges.insert(block.freeRanges.begin() + i + 1, tail);
+                }
+            }
+            else if (tail.size > 0)
+            {
+                range = tail;
+            }
+            else
+            {
+                block.freeRanges.erase(block.freeRanges.begin() + i);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    MemoryAllocation PaiDevice::allocateMemory(
+        const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties)
+    {
+        uint32_t memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bool hostVisible = (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+
+        // flushes and invalidations of host visible sub-allocations must land on
+        // nonCoherentAtomSize boundaries, so fold that into the alignment
+        VkDeviceSize alignment = memRequirements.alignment;
+        if (hostVisible && this->properties.limits.nonCoherentAtomSize > alignment)
+        {
+            alignment = this->properties.limits.nonCoherentAtomSize;
+        }
+
+        MemoryAllocation allocation{};
+        allocation.memoryTypeIndex = memoryTypeIndex;
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+        // very large requests get their own dedicated allocation rather than fragmenting a block
+        if (memRequirements.size > MEMORY_BLOCK_SIZE / 2)
         {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = memRequirements.size;
+            allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+            if (vkAllocateMemory(device_, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate dedicated buffer memory!");
+            }
+            trackHeapAllocation(heapIndexFor(memoryTypeIndex), memRequirements.size, false);
+            allocation.size = memRequirements.size;
+            allocation.dedicated = true;
+            if (hostVisible)
+            {
+                vkMapMemory(device_, allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped);
+            }
+            liveAllocationCount++;
+            liveAllocationBytes += allocation.size;
+            return allocation;
         }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+        for (auto &block : memoryPools[memoryTypeIndex])
+        {
+            if (carveFromBlock(block, memRequirements.size, alignment, allocation))
+            {
+                liveAllocationCount++;
+                liveAllocationBytes += allocation.size;
+                return allocation;
+            }
+        }
+
+        MemoryBlock &block = createMemoryBlock(memoryTypeIndex, hostVisible);
+        if (!carveFromBlock(block, memRequirements.size, alignment, allocation))
+        {
+            throw std::runtime_error("failed to sub-allocate from fresh memory block!");
+        }
+        liveAllocationCount++;
+        liveAllocationBytes += allocation.size;
+        return allocation;
+    }
+
+    void PaiDevice::freeMemory(const MemoryAllocation &allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        liveAllocationCount--;
+        liveAllocationBytes -= allocation.size;
+
+        if (allocation.dedicated)
+        {
+            untrackHeapAllocation(heapIndexFor(allocation.memoryTypeIndex), allocation.size, false);
+            vkFreeMemory(device_, allocation.memory, nullptr);
+            return;
+        }
+
+        auto &pool = memoryPools[allocation.memoryTypeIndex];
+        for (auto &block : pool)
+        {
+            if (block.id != allocation.blockId)
+            {
+                continue;
+            }
+
+            MemoryRange freed{allocation.offset, allocation.size};
+            auto it = block.freeRanges.begin();
+            while (it != block.freeRanges.end() && it->offset < freed.offset)
+            {
+                ++it;
+            }
+            it = block.freeRanges.insert(it, freed);
+
+            // merge with the following range, then with the preceding one
+            auto next = it + 1;
+            if (next != block.freeRanges.end() && it->offset + it->size == next->offset)
+            {
+                it->size += next->size;
+                block.freeRanges.erase(next);
+            }
+            if (it != block.freeRanges.begin())
+            {
+                auto prev = it - 1;
+                if (prev->offset + prev->size == it->offset)
+                {
+                    prev->size += it->size;
+                    block.freeRanges.erase(it);
+                }
+            }
+            return;
+        }
+    }
+
+    uint32_t PaiDevice::heapIndexFor(uint32_t memoryTypeIndex) const
+    {
+        return memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    }
+
+    void PaiDevice::trackHeapAllocation(uint32_t heapIndex, VkDeviceSize size, bool image)
+    {
+        HeapUsage &usage = heapUsage[heapIndex];
+        (image ? usage.imageBytes : usage.bufferBytes) += size;
+        VkDeviceSize total = usage.bufferBytes + usage.imageBytes;
+        if (total > usage.highWaterBytes)
+        {
+            usage.highWaterBytes = total;
+        }
+    }
+
+    void PaiDevice::untrackHeapAllocation(uint32_t heapIndex, VkDeviceSize size, bool image)
+    {
+        HeapUsage &usage = heapUsage[heapIndex];
+        (image ? usage.imageBytes : usage.bufferBytes) -= size;
+    }
+
+    std::vector<MemoryHeapStats> PaiDevice::getMemoryBudget() const
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+        memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        if (memoryBudgetSupported)
+        {
+            memoryProperties2.pNext = &budgetProperties;
+        }
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties2);
+
+        std::vector<MemoryHeapStats> heaps(memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            MemoryHeapStats &heap = heaps[i];
+            heap.size = memoryProperties.memoryHeaps[i].size;
+            heap.deviceLocal =
+                (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+            heap.budget = memoryBudgetSupported ? budgetProperties.heapBudget[i] : heap.size;
+            heap.usage = memoryBudgetSupported ? budgetProperties.heapUsage[i] : 0;
+            heap.bufferBytes = heapUsage[i].bufferBytes;
+            heap.imageBytes = heapUsage[i].imageBytes;
+            heap.highWaterBytes = heapUsage[i].highWaterBytes;
+        }
+        return heaps;
+    }
+
+    MemoryPoolStats PaiDevice::getMemoryPoolStats() const
+    {
+        MemoryPoolStats stats{};
+        stats.allocationCount = liveAllocationCount;
+        stats.allocatedBytes = liveAllocationBytes;
+        for (auto &kv : memoryPools)
+        {
+            for (auto &block : kv.second)
+            {
+                stats.blockCount++;
+                stats.blockBytes += block.size;
+                stats.freeRangeCount += static_cast<uint32_t>(block.freeRanges.size());
+                for (auto &range : block.freeRanges)
+                {
+                    if (range.size > stats.largestFreeRange)
+                    {
+                        stats.largestFreeRange = range.size;
+                    }
+                }
+            }
+        }
+        return stats;
     }
 
     VkCommandBuffer PaiDevice::beginSingleTimeCommands()
@@ -558,19 +992,166 @@ namespace pai
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
 
-    void PaiDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+    void PaiDevice::copyBuffer(
+        VkBuffer srcBuffer,
+        VkBuffer dstBuffer,
+        VkDeviceSize size,
+        VkDeviceSize srcOffset,
+        VkDeviceSize dstOffset)
     {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
         VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0; // Optional
-        copyRegion.dstOffset = 0; // Optional
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
         endSingleTimeCommands(commandBuffer);
     }
 
+    void PaiDevice::copyBufferRegions(
+        VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy> &regions)
+    {
+        if (regions.empty())
+        {
+            return;
+        }
+        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        vkCmdCopyBuffer(
+            commandBuffer,
+            srcBuffer,
+            dstBuffer,
+            static_cast<uint32_t>(regions.size()),
+            regions.data());
+        endSingleTimeCommands(commandBuffer);
+    }
+
+    VkCommandBuffer PaiDevice::beginTransferCommands()
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = transferCommandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+    }
+
+    void PaiDevice::submitTransferCommands(VkCommandBuffer commandBuffer)
+    {
+        vkEndCommandBuffer(commandBuffer);
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create transfer fence!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        vkQueueSubmit(transferQueue_, 1, &submitInfo, fence);
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+
+        vkDestroyFence(device_, fence, nullptr);
+        vkFreeCommandBuffers(device_, transferCommandPool, 1, &commandBuffer);
+    }
+
+    VkFence PaiDevice::copyBufferAsync(
+        VkBuffer srcBuffer,
+        VkBuffer dstBuffer,
+        VkDeviceSize size,
+        VkDeviceSize srcOffset,
+        VkDeviceSize dstOffset)
+    {
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        return copyBufferRegionsAsync(srcBuffer, dstBuffer, {copyRegion});
+    }
+
+    VkFence PaiDevice::copyBufferRegionsAsync(
+        VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy> &regions)
+    {
+        if (regions.empty())
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = transferCommandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        vkCmdCopyBuffer(
+            commandBuffer,
+            srcBuffer,
+            dstBuffer,
+            static_cast<uint32_t>(regions.size()),
+            regions.data());
+        vkEndCommandBuffer(commandBuffer);
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create transfer fence!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        vkQueueSubmit(transferQueue_, 1, &submitInfo, fence);
+
+        pendingTransfers.push_back({fence, commandBuffer});
+        return fence;
+    }
+
+    void PaiDevice::waitForTransfer(VkFence fence)
+    {
+        if (fence == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        for (auto it = pendingTransfers.begin(); it != pendingTransfers.end(); ++it)
+        {
+            if (it->fence == fence)
+            {
+                vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+                vkDestroyFence(device_, fence, nullptr);
+                vkFreeCommandBuffers(device_, transferCommandPool, 1, &it->commandBuffer);
+                pendingTransfers.erase(it);
+                return;
+            }
+        }
+    }
+
     void PaiDevice::copyBufferToImage(
         VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount)
     {
@@ -622,6 +1203,9 @@ namespace pai
         {
             throw std::runtime_error("failed to allocate image memory!");
         }
+        uint32_t heapIndex = heapIndexFor(allocInfo.memoryTypeIndex);
+        trackHeapAllocation(heapIndex, memRequirements.size, true);
+        imageAllocations[imageMemory] = {memRequirements.size, heapIndex};
 
         if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
         {
@@ -629,4 +1213,19 @@ namespace pai
         }
     }
 
+    void PaiDevice::freeImageMemory(VkDeviceMemory imageMemory)
+    {
+        if (imageMemory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        auto it = imageAllocations.find(imageMemory);
+        if (it != imageAllocations.end())
+        {
+            untrackHeapAllocation(it->second.heapIndex, it->second.size, true);
+            imageAllocations.erase(it);
+        }
+        vkFreeMemory(device_, imageMemory, nullptr);
+    }
+
 }
\ No newline at end of file
@@ -3,11 +3,44 @@
 #include "pai_window.hpp"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace pai
 {
 
+    struct MemoryAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        void *mapped = nullptr; // base of the owning block's persistent mapping, host visible only
+        uint32_t blockId = 0;
+        bool dedicated = false;
+    };
+
+    struct MemoryPoolStats
+    {
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize allocatedBytes = 0; // bytes handed out to sub-allocations
+        VkDeviceSize blockBytes = 0;     // bytes reserved from the driver
+        uint32_t freeRangeCount = 0;     // fragmentation indicator
+        VkDeviceSize largestFreeRange = 0;
+    };
+
+    struct MemoryHeapStats
+    {
+        VkDeviceSize size = 0;           // physical heap size
+        VkDeviceSize budget = 0;         // driver budget (VK_EXT_memory_budget), else heap size
+        VkDeviceSize usage = 0;          // driver-reported process usage, 0 without the extension
+        VkDeviceSize bufferBytes = 0;    // our buffer blocks and dedicated buffer allocations
+        VkDeviceSize imageBytes = 0;     // our image allocations
+        VkDeviceSize highWaterBytes = 0; // session peak of bufferBytes + imageBytes
+        bool deviceLocal = false;
+    };
+
     struct SwapChainSupportDetails
     {
         VkSurfaceCapabilitiesKHR capabilities;
@@ -19,8 +52,10 @@ namespace pai
     {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -34,6 +69,9 @@ namespace pai
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createTransferCommandPool();
+        void createPipelineCache();
+        void savePipelineCache();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -45,16 +83,78 @@ namespace pai
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
+        struct MemoryRange
+        {
+            VkDeviceSize offset;
+            VkDeviceSize size;
+        };
+
+        struct MemoryBlock
+        {
+            uint32_t id;
+            VkDeviceMemory memory;
+            VkDeviceSize size;
+            void *mapped;
+            std::vector<MemoryRange> freeRanges; // sorted by offset
+        };
+
+        static constexpr VkDeviceSize MEMORY_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        MemoryBlock &createMemoryBlock(uint32_t memoryTypeIndex, bool hostVisible);
+        bool carveFromBlock(
+            MemoryBlock &block, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation &allocation);
+
+        std::unordered_map<uint32_t, std::vector<MemoryBlock>> memoryPools;
+        uint32_t nextBlockId = 1;
+        uint32_t liveAllocationCount = 0;
+        VkDeviceSize liveAllocationBytes = 0;
+
+        // Per-heap accounting of everything we take from the driver, so exhaustion
+        // on small cards shows up in getMemoryBudget instead of as a mid-run
+        // VK_ERROR_OUT_OF_DEVICE_MEMORY. Counts driver-level allocations (pool
+        // blocks, dedicated buffers, images), not sub-allocations.
+        struct HeapUsage
+        {
+            VkDeviceSize bufferBytes = 0;
+            VkDeviceSize imageBytes = 0;
+            VkDeviceSize highWaterBytes = 0;
+        };
+
+        struct ImageAllocation
+        {
+            VkDeviceSize size;
+            uint32_t heapIndex;
+        };
+
+        uint32_t heapIndexFor(uint32_t memoryTypeIndex) const;
+        void trackHeapAllocation(uint32_t heapIndex, VkDeviceSize size, bool image);
+        void untrackHeapAllocation(uint32_t heapIndex, VkDeviceSize size, bool image);
+
+        std::vector<HeapUsage> heapUsage; // indexed by memory heap
+        std::unordered_map<VkDeviceMemory, ImageAllocation> imageAllocations;
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        bool memoryBudgetSupported = false;
+
+        struct PendingTransfer
+        {
+            VkFence fence;
+            VkCommandBuffer commandBuffer;
+        };
+        std::vector<PendingTransfer> pendingTransfers;
+
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         PaiWindow &window;
         VkCommandPool commandPool;
+        VkCommandPool transferCommandPool;
+        VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -80,23 +180,60 @@ namespace pai
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        VkQueue transferQueue() { return transferQueue_; }
+        VkPipelineCache pipelineCache() { return pipelineCache_; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        // whether any memory type carries all the given properties; use to detect
+        // host-visible device-local heaps (ReBAR) before requesting them
+        bool hasMemoryType(VkMemoryPropertyFlags properties);
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
         VkFormat findSupportedFormat(
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
+        // Memory pool functions. Sub-allocates out of large shared blocks per memory type so
+        // buffer creation does not hit the driver's allocation-count limit.
+        MemoryAllocation allocateMemory(
+            const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties);
+        void freeMemory(const MemoryAllocation &allocation);
+        MemoryPoolStats getMemoryPoolStats() const;
+        // Per-heap snapshot: what the engine allocated (split buffer vs image), what
+        // the driver says this process may use, and the session's high-water mark.
+        // Use it to size worlds and frames-in-flight buffering to the deployed card.
+        std::vector<MemoryHeapStats> getMemoryBudget() const;
+
         // Buffer Helper Functions
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory);
+            MemoryAllocation &allocation);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        VkCommandBuffer beginTransferCommands();
+        void submitTransferCommands(VkCommandBuffer commandBuffer);
+        void copyBuffer(
+            VkBuffer srcBuffer,
+            VkBuffer dstBuffer,
+            VkDeviceSize size,
+            VkDeviceSize srcOffset = 0,
+            VkDeviceSize dstOffset = 0);
+        void copyBufferRegions(
+            VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy> &regions);
+
+        // Async copies on the transfer queue. The returned fence must be handed back to
+        // waitForTransfer before the staging source is reused or the device is destroyed.
+        VkFence copyBufferAsync(
+            VkBuffer srcBuffer,
+            VkBuffer dstBuffer,
+            VkDeviceSize size,
+            VkDeviceSize srcOffset = 0,
+            VkDeviceSize dstOffset = 0);
+        VkFence copyBufferRegionsAsync(
+            VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy> &regions);
+        void waitForTransfer(VkFence fence);
         void copyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -105,6 +242,9 @@ namespace pai
             VkMemoryPropertyFlags properties,
             VkImage &image,
             VkDeviceMemory &imageMemory);
+        // Counterpart of createImageWithInfo; frees the memory and drops it from
+        // the heap accounting. Use instead of a raw vkFreeMemory.
+        void freeImageMemory(VkDeviceMemory imageMemory);
 
         VkPhysicalDeviceProperties properties;
     };
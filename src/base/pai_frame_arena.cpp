@@ -0,0 +1,64 @@
+#include "pai_frame_arena.hpp"
+
+// std
+#include <algorithm>
+#include <cstdint>
+
+namespace pai
+{
+
+    PaiFrameArena::PaiFrameArena(size_t blockSize) : blockSize{blockSize}
+    {
+        grow(blockSize);
+    }
+
+    PaiFrameArena::Block &PaiFrameArena::grow(size_t minimumSize)
+    {
+        size_t size = std::max(blockSize, minimumSize);
+        blocks.push_back({std::make_unique<char[]>(size), size, 0});
+        currentBlock = blocks.size() - 1;
+        return blocks.back();
+    }
+
+    void *PaiFrameArena::allocate(size_t size, size_t alignment)
+    {
+        auto *block = &blocks[currentBlock];
+        size_t aligned = (block->used + alignment - 1) & ~(alignment - 1);
+        if (aligned + size > block->size)
+        {
+            // spill into a fresh block; reset() folds the arena back together
+            block = &grow(size + alignment);
+            aligned = 0;
+        }
+        block->used = aligned + size;
+        return block->data.get() + aligned;
+    }
+
+    void PaiFrameArena::reset()
+    {
+        if (blocks.size() > 1)
+        {
+            // replace the fragmented chain with one block big enough for the frame
+            size_t total = 0;
+            for (auto &block : blocks)
+            {
+                total += block.size;
+            }
+            blocks.clear();
+            grow(total);
+        }
+        blocks[0].used = 0;
+        currentBlock = 0;
+    }
+
+    size_t PaiFrameArena::bytesUsed() const
+    {
+        size_t total = 0;
+        for (auto &block : blocks)
+        {
+            total += block.used;
+        }
+        return total;
+    }
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace pai
+{
+
+    // Frame-scoped linear allocator: allocations bump a pointer inside a block and
+    // are all released at once by reset(), called from PaiRenderer::beginFrame.
+    // Nothing is freed individually, so frame-lifetime containers built on it never
+    // touch the global heap after warm-up. Not thread-safe; allocate from the main
+    // thread only.
+    class PaiFrameArena
+    {
+    public:
+        PaiFrameArena(size_t blockSize = 256 * 1024);
+
+        PaiFrameArena(const PaiFrameArena &) = delete;
+        PaiFrameArena &operator=(const PaiFrameArena &) = delete;
+
+        void *allocate(size_t size, size_t alignment);
+        // releases every allocation; keeps the blocks for reuse
+        void reset();
+
+        size_t bytesUsed() const;
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<char[]> data;
+            size_t size;
+            size_t used;
+        };
+
+        Block &grow(size_t minimumSize);
+
+        std::vector<Block> blocks;
+        size_t currentBlock = 0;
+        size_t blockSize;
+    };
+
+    // STL adapter; deallocate is a no-op because the arena frees wholesale on reset
+    template <typename T>
+    class PaiFrameArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        PaiFrameArenaAllocator(PaiFrameArena &arena) : arena{&arena} {}
+        template <typename U>
+        PaiFrameArenaAllocator(const PaiFrameArenaAllocator<U> &other) : arena{other.arena}
+        {
+        }
+
+        T *allocate(size_t count)
+        {
+            return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+        void deallocate(T *, size_t) {}
+
+        bool operator==(const PaiFrameArenaAllocator &other) const { return arena == other.arena; }
+        bool operator!=(const PaiFrameArenaAllocator &other) const { return arena != other.arena; }
+
+        PaiFrameArena *arena;
+    };
+
+    template <typename T>
+    using FrameVector = std::vector<T, PaiFrameArenaAllocator<T>>;
+
+}
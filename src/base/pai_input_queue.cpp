@@ -0,0 +1,32 @@
+#include "pai_input_queue.hpp"
+
+namespace pai
+{
+
+    PaiInputQueue::PaiInputQueue(size_t capacity) : ring(capacity) {}
+
+    void PaiInputQueue::push(const KeyEvent &event)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= ring.size())
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring[h % ring.size()] = event;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    bool PaiInputQueue::pop(KeyEvent &event)
+    {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        event = ring[t % ring.size()];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+}
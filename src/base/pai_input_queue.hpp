@@ -0,0 +1,45 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pai
+{
+    // Single-producer single-consumer lock-free ring for keyboard events. The
+    // GLFW key callback pushes, the simulation step pops. GLFW delivers events
+    // on the main thread, so the queue decouples input sampling from render
+    // cadence rather than from a thread: taps delivered while the renderer is
+    // blocked keep their timestamps instead of being lost to a missed
+    // glfwGetKey poll, and a drained event stream replays deterministically.
+    class PaiInputQueue
+    {
+    public:
+        struct KeyEvent
+        {
+            int key;
+            int action;       // GLFW_PRESS or GLFW_RELEASE
+            double timestamp; // glfwGetTime() at delivery
+        };
+
+        PaiInputQueue(size_t capacity = 256);
+
+        PaiInputQueue(const PaiInputQueue &) = delete;
+        PaiInputQueue &operator=(const PaiInputQueue &) = delete;
+
+        // Producer side; drops the event and counts it when the ring is full
+        void push(const KeyEvent &event);
+        // Consumer side; false when the ring is empty
+        bool pop(KeyEvent &event);
+
+        uint64_t droppedEvents() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<KeyEvent> ring;
+        std::atomic<uint64_t> head{0}; // next slot to write, producer only
+        std::atomic<uint64_t> tail{0}; // next slot to read, consumer only
+        std::atomic<uint64_t> dropped{0};
+    };
+}
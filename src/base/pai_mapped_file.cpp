@@ -0,0 +1,45 @@
+#include "pai_mapped_file.hpp"
+
+// std
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pai
+{
+    PaiMappedFile::PaiMappedFile(const std::string &filepath)
+    {
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(fd);
+            throw std::runtime_error("failed to stat file: " + filepath);
+        }
+        fileSize = static_cast<size_t>(fileStat.st_size);
+
+        mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file alive
+        if (mapped == MAP_FAILED)
+        {
+            mapped = nullptr;
+            throw std::runtime_error("failed to map file: " + filepath);
+        }
+    }
+
+    PaiMappedFile::~PaiMappedFile()
+    {
+        if (mapped != nullptr)
+        {
+            munmap(mapped, fileSize);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <string>
+
+namespace pai
+{
+    // Read-only memory-mapped view of a file. The mapping is page-cache backed, so
+    // consumers like vkCreateShaderModule read the bytes without an intermediate
+    // heap copy. Throws std::runtime_error when the file can't be opened or mapped.
+    class PaiMappedFile
+    {
+    public:
+        PaiMappedFile(const std::string &filepath);
+        ~PaiMappedFile();
+
+        PaiMappedFile(const PaiMappedFile &) = delete;
+        PaiMappedFile &operator=(const PaiMappedFile &) = delete;
+
+        const char *data() const { return static_cast<const char *>(mapped); }
+        size_t size() const { return fileSize; }
+
+    private:
+        void *mapped = nullptr;
+        size_t fileSize = 0;
+    };
+}
@@ -1,8 +1,13 @@
 #include "pai_pipeline.hpp"
+#include "pai_mapped_file.hpp"
 #include "pai_model.hpp"
 #include "pai_pixel.hpp"
+#include "pai_swap_chain.hpp"
+
+#include <sys/stat.h>
 
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -19,9 +24,36 @@ namespace pai
         PaiDevice &device,
         const std::string &vertFilepath,
         const std::string &fragFilepath,
-        const PipelineConfigInfo &configInfo) : paiDevice{device}
+        const PipelineConfigInfo &configInfo)
+        : paiDevice{device}, shaderPaths{vertFilepath, fragFilepath}
+    {
+        graphicsPipeline = createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+    }
+
+    PaiPipeline::PaiPipeline(
+        PaiDevice &device,
+        const std::string &vertFilepath,
+        const std::string &geomFilepath,
+        const std::string &fragFilepath,
+        const PipelineConfigInfo &configInfo)
+        : paiDevice{device}, shaderPaths{vertFilepath, geomFilepath, fragFilepath}
+    {
+        graphicsPipeline = createGraphicsPipeline(vertFilepath, geomFilepath, fragFilepath, configInfo);
+    }
+
+    PaiPipeline::PaiPipeline(
+        PaiDevice &device,
+        const std::string &vertFilepath,
+        const std::string &fragFilepath,
+        std::unique_ptr<PipelineConfigInfo> configInfo)
+        : paiDevice{device},
+          shaderPaths{vertFilepath, fragFilepath},
+          ownedConfig{std::move(configInfo)}
     {
-        createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+        pendingPipeline = std::async(
+            std::launch::async,
+            [this, vertFilepath, fragFilepath, config = ownedConfig.get()]()
+            { return createGraphicsPipeline(vertFilepath, fragFilepath, *config); });
     }
 
     PaiPipeline::PaiPipeline(
@@ -29,16 +61,107 @@ namespace pai
         const std::string &vertFilepath,
         const std::string &geomFilepath,
         const std::string &fragFilepath,
-        const PipelineConfigInfo &configInfo) : paiDevice{device}
+        std::unique_ptr<PipelineConfigInfo> configInfo)
+        : paiDevice{device},
+          shaderPaths{vertFilepath, geomFilepath, fragFilepath},
+          ownedConfig{std::move(configInfo)}
     {
-        createGraphicsPipeline(vertFilepath, geomFilepath, fragFilepath, configInfo);
+        pendingPipeline = std::async(
+            std::launch::async,
+            [this, vertFilepath, geomFilepath, fragFilepath, config = ownedConfig.get()]()
+            { return createGraphicsPipeline(vertFilepath, geomFilepath, fragFilepath, *config); });
     }
 
     PaiPipeline::~PaiPipeline()
     {
+        if (watcherRunning.exchange(false))
+        {
+            watcherThread.join();
+        }
+        if (pendingPipeline.valid())
+        {
+            graphicsPipeline = pendingPipeline.get();
+        }
+        VkPipeline unconsumed = reloadedPipeline.exchange(VK_NULL_HANDLE);
+        if (unconsumed != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(paiDevice.device(), unconsumed, nullptr);
+        }
+        for (auto &retired : retiredPipelines)
+        {
+            vkDestroyPipeline(paiDevice.device(), retired.pipeline, nullptr);
+        }
         vkDestroyPipeline(paiDevice.device(), graphicsPipeline, nullptr);
     }
 
+    void PaiPipeline::watchForReload()
+    {
+        assert(ownedConfig != nullptr && "hot reload requires a config-owning constructor");
+        if (watcherRunning.exchange(true))
+        {
+            return;
+        }
+        watcherThread = std::thread([this]() { watchLoop(); });
+    }
+
+    void PaiPipeline::watchLoop()
+    {
+        auto modifyTimes = [this](std::vector<time_t> &times)
+        {
+            times.clear();
+            for (const auto &path : shaderPaths)
+            {
+                struct stat fileInfo
+                {
+                };
+                times.push_back(
+                    ::stat((ENGINE_DIR + path).c_str(), &fileInfo) == 0 ? fileInfo.st_mtime : 0);
+            }
+        };
+
+        std::vector<time_t> lastTimes;
+        std::vector<time_t> currentTimes;
+        modifyTimes(lastTimes);
+        while (watcherRunning.load(std::memory_order_relaxed))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            modifyTimes(currentTimes);
+            if (currentTimes == lastTimes)
+            {
+                continue;
+            }
+            lastTimes = currentTimes;
+            // the compiler may still be writing the blob; give it a beat
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            try
+            {
+                VkPipeline rebuilt = buildFromShaderPaths(*ownedConfig);
+                VkPipeline unconsumed =
+                    reloadedPipeline.exchange(rebuilt, std::memory_order_release);
+                if (unconsumed != VK_NULL_HANDLE)
+                {
+                    // superseded before any bind saw it, so the GPU never had it
+                    vkDestroyPipeline(paiDevice.device(), unconsumed, nullptr);
+                }
+                std::cout << "reloaded pipeline: " << shaderPaths.back() << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                // half-written .spv or a compile failure; keep the old pipeline
+                std::cerr << "shader reload failed: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    VkPipeline PaiPipeline::buildFromShaderPaths(const PipelineConfigInfo &configInfo)
+    {
+        if (shaderPaths.size() == 3)
+        {
+            return createGraphicsPipeline(shaderPaths[0], shaderPaths[1], shaderPaths[2], configInfo);
+        }
+        return createGraphicsPipeline(shaderPaths[0], shaderPaths[1], configInfo);
+    }
+
     std::vector<char> PaiPipeline::readFile(const std::string &filepath)
     {
         std::string enginePath = ENGINE_DIR + filepath;
@@ -60,7 +183,7 @@ namespace pai
         return buffer;
     }
 
-    void PaiPipeline::createGraphicsPipeline(
+    VkPipeline PaiPipeline::createGraphicsPipeline(
         const std::string &vertFilepath,
         const std::string &fragFilepath,
         const PipelineConfigInfo &configInfo)
@@ -72,13 +195,14 @@ namespace pai
             configInfo.renderPass != nullptr &&
             "Cannot create graphics pipeline: no renderPass provided in config info");
 
-        auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
+        // map the blobs instead of streaming them through an ifstream copy
+        PaiMappedFile vertCode{ENGINE_DIR + vertFilepath};
+        PaiMappedFile fragCode{ENGINE_DIR + fragFilepath};
         VkShaderModule vertShaderModule;
         VkShaderModule fragShaderModule;
 
-        createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+        createShaderModule(vertCode.data(), vertCode.size(), &vertShaderModule);
+        createShaderModule(fragCode.data(), fragCode.size(), &fragShaderModule);
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -96,6 +220,18 @@ namespace pai
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
+        VkSpecializationInfo specializationInfo{};
+        if (!configInfo.specializationEntries.empty())
+        {
+            specializationInfo.mapEntryCount =
+                static_cast<uint32_t>(configInfo.specializationEntries.size());
+            specializationInfo.pMapEntries = configInfo.specializationEntries.data();
+            specializationInfo.dataSize = configInfo.specializationData.size();
+            specializationInfo.pData = configInfo.specializationData.data();
+            shaderStages[0].pSpecializationInfo = &specializationInfo;
+            shaderStages[1].pSpecializationInfo = &specializationInfo;
+        }
+
         auto &bindingDescriptions = configInfo.bindingDescriptions;
         auto &attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -126,13 +262,14 @@ namespace pai
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex = -1;              // Optional
 
+        VkPipeline pipeline;
         if (vkCreateGraphicsPipelines(
                 paiDevice.device(),
-                VK_NULL_HANDLE,
+                paiDevice.pipelineCache(),
                 1,
                 &pipelineInfo,
                 nullptr,
-                &graphicsPipeline) != VK_SUCCESS)
+                &pipeline) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create graphics pipeline!");
         }
@@ -141,9 +278,10 @@ namespace pai
         vkDestroyShaderModule(paiDevice.device(), vertShaderModule, nullptr);
         fragShaderModule = VK_NULL_HANDLE;
         vertShaderModule = VK_NULL_HANDLE;
+        return pipeline;
     }
 
-    void PaiPipeline::createGraphicsPipeline(
+    VkPipeline PaiPipeline::createGraphicsPipeline(
         const std::string &vertFilepath,
         const std::string &geomFilepath,
         const std::string &fragFilepath,
@@ -156,16 +294,16 @@ namespace pai
             configInfo.renderPass != nullptr &&
             "Cannot create graphics pipeline: no renderPass provided in config info");
 
-        auto vertCode = readFile(vertFilepath);
-        auto geomCode = readFile(geomFilepath);
-        auto fragCode = readFile(fragFilepath);
+        PaiMappedFile vertCode{ENGINE_DIR + vertFilepath};
+        PaiMappedFile geomCode{ENGINE_DIR + geomFilepath};
+        PaiMappedFile fragCode{ENGINE_DIR + fragFilepath};
         VkShaderModule vertShaderModule;
         VkShaderModule geomShaderModule;
         VkShaderModule fragShaderModule;
 
-        createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(geomCode, &geomShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+        createShaderModule(vertCode.data(), vertCode.size(), &vertShaderModule);
+        createShaderModule(geomCode.data(), geomCode.size(), &geomShaderModule);
+        createShaderModule(fragCode.data(), fragCode.size(), &fragShaderModule);
 
         VkPipelineShaderStageCreateInfo shaderStages[3];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -190,6 +328,19 @@ namespace pai
         shaderStages[2].pNext = nullptr;
         shaderStages[2].pSpecializationInfo = nullptr;
 
+        VkSpecializationInfo specializationInfo{};
+        if (!configInfo.specializationEntries.empty())
+        {
+            specializationInfo.mapEntryCount =
+                static_cast<uint32_t>(configInfo.specializationEntries.size());
+            specializationInfo.pMapEntries = configInfo.specializationEntries.data();
+            specializationInfo.dataSize = configInfo.specializationData.size();
+            specializationInfo.pData = configInfo.specializationData.data();
+            shaderStages[0].pSpecializationInfo = &specializationInfo;
+            shaderStages[1].pSpecializationInfo = &specializationInfo;
+            shaderStages[2].pSpecializationInfo = &specializationInfo;
+        }
+
         auto &bindingDescriptions = configInfo.bindingDescriptions;
         auto &attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -220,13 +371,14 @@ namespace pai
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex = -1;              // Optional
  
+        VkPipeline pipeline;
         if (vkCreateGraphicsPipelines(
                 paiDevice.device(),
-                VK_NULL_HANDLE,
+                paiDevice.pipelineCache(),
                 1,
                 &pipelineInfo,
                 nullptr,
-                &graphicsPipeline) != VK_SUCCESS)
+                &pipeline) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create graphics pipeline!");
         }
@@ -237,14 +389,21 @@ namespace pai
         fragShaderModule = VK_NULL_HANDLE;
         geomShaderModule = VK_NULL_HANDLE;
         vertShaderModule = VK_NULL_HANDLE;
+        return pipeline;
     }
 
     void PaiPipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule)
+    {
+        createShaderModule(code.data(), code.size(), shaderModule);
+    }
+
+    void PaiPipeline::createShaderModule(
+        const char *code, size_t codeSize, VkShaderModule *shaderModule)
     {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        createInfo.codeSize = codeSize;
+        createInfo.pCode = reinterpret_cast<const uint32_t *>(code);
 
         if (vkCreateShaderModule(paiDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
         {
@@ -328,6 +487,15 @@ namespace pai
         configInfo.attributeDescriptions = PaiPixel::Vertex::getAttributeDescriptions();
     }
 
+    void PaiPipeline::pixelInstancedPipelineConfigInfo(PipelineConfigInfo &configInfo)
+    {
+        // same fixed-function state as the point/geometry path, but the cell buffer is
+        // read per instance and the quad comes from a 4-vertex triangle strip
+        pixelPipelineConfigInfo(configInfo);
+        configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        configInfo.bindingDescriptions = PaiPixel::Vertex::getInstanceBindingDescriptions();
+    }
+
 
     void PaiPipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo)
     {
@@ -407,6 +575,40 @@ namespace pai
 
     void PaiPipeline::bind(VkCommandBuffer commandBuffer)
     {
+        if (pendingPipeline.valid())
+        {
+            graphicsPipeline = pendingPipeline.get();
+        }
+
+        // the variant cache binds the same pipeline once per grid, so binds don't
+        // map 1:1 to frames; a fresh command buffer marks the first bind of a frame
+        // and that's when retired handles count down and reloads swap in
+        bool firstBindOfFrame = commandBuffer != lastCommandBuffer;
+        lastCommandBuffer = commandBuffer;
+        if (firstBindOfFrame)
+        {
+            for (auto it = retiredPipelines.begin(); it != retiredPipelines.end();)
+            {
+                if (--it->framesRemaining <= 0)
+                {
+                    vkDestroyPipeline(paiDevice.device(), it->pipeline, nullptr);
+                    it = retiredPipelines.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            VkPipeline rebuilt =
+                reloadedPipeline.exchange(VK_NULL_HANDLE, std::memory_order_acquire);
+            if (rebuilt != VK_NULL_HANDLE)
+            {
+                retiredPipelines.push_back({graphicsPipeline, PaiSwapChain::MAX_FRAMES_IN_FLIGHT});
+                graphicsPipeline = rebuilt;
+            }
+        }
+
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
     }
 
@@ -424,4 +626,18 @@ namespace pai
         configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
     }
 
+    void PaiPipeline::addSpecializationConstant(
+        PipelineConfigInfo &configInfo, uint32_t constantId, const void *value, size_t size)
+    {
+        VkSpecializationMapEntry entry{};
+        entry.constantID = constantId;
+        entry.offset = static_cast<uint32_t>(configInfo.specializationData.size());
+        entry.size = size;
+        configInfo.specializationEntries.push_back(entry);
+
+        const char *bytes = static_cast<const char *>(value);
+        configInfo.specializationData.insert(
+            configInfo.specializationData.end(), bytes, bytes + size);
+    }
+
 }
\ No newline at end of file
@@ -2,7 +2,11 @@
 
 #include "pai_device.hpp"
 
+#include <atomic>
+#include <future>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace pai
@@ -28,39 +32,82 @@ namespace pai
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+
+        // specialization constants applied to every stage; the config owns the
+        // storage so async builds don't dangle. Fill with addSpecializationConstant.
+        std::vector<VkSpecializationMapEntry> specializationEntries{};
+        std::vector<char> specializationData{};
     };
 
     class PaiPipeline
     {
     private:
         PaiDevice &paiDevice;
-        VkPipeline graphicsPipeline;
+        VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+        std::future<VkPipeline> pendingPipeline;
 
-        static std::vector<char> readFile(const std::string &filename);
-        void createGraphicsPipeline(
+        // hot reload: the watcher polls the .spv mtimes, rebuilds off-thread and
+        // parks the handle here; bind swaps it in and retires the old pipeline
+        std::vector<std::string> shaderPaths;            // vert[, geom], frag as constructed
+        std::unique_ptr<PipelineConfigInfo> ownedConfig; // kept around for rebuilds
+        std::thread watcherThread;
+        std::atomic<bool> watcherRunning{false};
+        std::atomic<VkPipeline> reloadedPipeline{VK_NULL_HANDLE};
+
+        struct RetiredPipeline
+        {
+            VkPipeline pipeline;
+            int framesRemaining;
+        };
+        std::vector<RetiredPipeline> retiredPipelines;
+        // the renderer reuses one command buffer per frame in flight, so a new
+        // handle here marks a new frame even when bind runs several times per frame
+        VkCommandBuffer lastCommandBuffer = VK_NULL_HANDLE;
+
+        void watchLoop();
+        VkPipeline buildFromShaderPaths(const PipelineConfigInfo &configInfo);
+
+        VkPipeline createGraphicsPipeline(
             const std::string &vertFilepath,
             const std::string &fragFilepath,
             const PipelineConfigInfo &configInfo);
-        void createGraphicsPipeline(
+        VkPipeline createGraphicsPipeline(
             const std::string &vertFilepath,
             const std::string &geomFilepath,
             const std::string &fragFilepath,
             const PipelineConfigInfo &configInfo);
         void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
+        void createShaderModule(const char *code, size_t codeSize, VkShaderModule *shaderModule);
 
     public:
         PaiPipeline(PaiDevice &device, const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
         PaiPipeline(PaiDevice &device, const std::string &vertFilepath, const std::string &geomFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
 
+        // Async variants read the .spv files and build the pipeline on a worker thread.
+        // The first bind (or destruction) blocks until the pipeline is ready; the config
+        // is taken by unique_ptr so it outlives the caller's stack frame.
+        PaiPipeline(PaiDevice &device, const std::string &vertFilepath, const std::string &fragFilepath, std::unique_ptr<PipelineConfigInfo> configInfo);
+        PaiPipeline(PaiDevice &device, const std::string &vertFilepath, const std::string &geomFilepath, const std::string &fragFilepath, std::unique_ptr<PipelineConfigInfo> configInfo);
+
         ~PaiPipeline();
 
         PaiPipeline(const PaiPipeline &) = delete;
         PaiPipeline &operator=(const PaiPipeline &) = delete;
 
         void bind(VkCommandBuffer commandBuffer);
+        // Watches this pipeline's .spv files and rebuilds on change, entirely off
+        // the render thread (the build shares the device pipeline cache). The first
+        // bind of a frame picks up the result and retires the old handle once the
+        // frames that may still reference it have drained. Requires a config-owning
+        // (async) constructor so the rebuild has the fixed-function state to hand.
+        void watchForReload();
+        static std::vector<char> readFile(const std::string &filename);
         static void pixelPipelineConfigInfo(PipelineConfigInfo &configInfo);
+        static void pixelInstancedPipelineConfigInfo(PipelineConfigInfo &configInfo);
         static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
         static void enableAlphaBlending(PipelineConfigInfo &configInfo);
+        static void addSpecializationConstant(
+            PipelineConfigInfo &configInfo, uint32_t constantId, const void *value, size_t size);
     };
 
 }
\ No newline at end of file
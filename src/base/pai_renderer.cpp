@@ -1,9 +1,14 @@
 #include "pai_renderer.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <fstream>
+#include <future>
 #include <stdexcept>
+#include <thread>
 
 namespace pai
 {
@@ -13,9 +18,45 @@ namespace pai
     {
         recreateSwapChain();
         createCommandBuffers();
+        createTimestampQueryPool();
     }
 
-    PaiRenderer::~PaiRenderer() { freeCommandBuffers(); }
+    PaiRenderer::~PaiRenderer()
+    {
+        if (timestampQueryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(paiDevice.device(), timestampQueryPool, nullptr);
+        }
+        for (auto &frameRecorders : secondaryRecorders)
+        {
+            for (auto &recorder : frameRecorders)
+            {
+                vkDestroyCommandPool(paiDevice.device(), recorder.pool, nullptr);
+            }
+        }
+        freeCommandBuffers();
+    }
+
+    void PaiRenderer::createTimestampQueryPool()
+    {
+        timestampPeriod = paiDevice.properties.limits.timestampPeriod;
+        if (timestampPeriod == 0.f || !paiDevice.properties.limits.timestampComputeAndGraphics)
+        {
+            return; // device can't timestamp, scopes become no-ops
+        }
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = PaiSwapChain::MAX_FRAMES_IN_FLIGHT * MAX_GPU_SCOPES * 2;
+
+        if (vkCreateQueryPool(paiDevice.device(), &poolInfo, nullptr, &timestampQueryPool) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        gpuScopes.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+    }
 
     void PaiRenderer::recreateSwapChain()
     {
@@ -25,22 +66,61 @@ namespace pai
             extent = paiWindow.getExtent();
             glfwWaitEvents();
         }
-        vkDeviceWaitIdle(paiDevice.device());
-
         if (paiSwapChain == nullptr)
         {
-            paiSwapChain = std::make_unique<PaiSwapChain>(paiDevice, extent);
+            paiSwapChain = std::make_unique<PaiSwapChain>(paiDevice, extent, presentPolicy);
         }
         else
         {
             std::shared_ptr<PaiSwapChain> oldSwapChain = std::move(paiSwapChain);
-            paiSwapChain = std::make_unique<PaiSwapChain>(paiDevice, extent, oldSwapChain);
+            paiSwapChain =
+                std::make_unique<PaiSwapChain>(paiDevice, extent, oldSwapChain, presentPolicy);
 
             if (!oldSwapChain->compareSwapFormats(*paiSwapChain.get()))
             {
                 throw std::runtime_error("Swap chain image(or depth) format has changed!");
             }
+            // the old chain's frames may still be on the GPU; park it until its own
+            // fences say they retired instead of stalling the whole device
+            retiredSwapChains.push_back(std::move(oldSwapChain));
         }
+        retireCompletedSwapChains();
+        stats.presentMode = paiSwapChain->presentModeName();
+    }
+
+    void PaiRenderer::retireCompletedSwapChains()
+    {
+        retiredSwapChains.erase(
+            std::remove_if(
+                retiredSwapChains.begin(),
+                retiredSwapChains.end(),
+                [](const std::shared_ptr<PaiSwapChain> &swapChain)
+                { return swapChain->framesInFlightComplete(); }),
+            retiredSwapChains.end());
+    }
+
+    void PaiRenderer::setPresentPolicy(PaiSwapChain::PresentPolicy policy)
+    {
+        assert(!isFrameStarted && "Can't change present policy while a frame is in progress");
+        if (policy == presentPolicy)
+        {
+            return;
+        }
+        presentPolicy = policy;
+        recreateSwapChain();
+    }
+
+    void PaiRenderer::setTargetFrameRate(float framesPerSecond)
+    {
+        if (framesPerSecond <= 0.f)
+        {
+            framePeriod = std::chrono::steady_clock::duration::zero();
+            stats.pacingWaitMs = 0.f;
+            return;
+        }
+        framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(1.f / framesPerSecond));
+        nextFrameDeadline = std::chrono::steady_clock::now() + framePeriod;
     }
 
     void PaiRenderer::createCommandBuffers()
@@ -74,6 +154,13 @@ namespace pai
     {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
+        frameArena.reset(); // everything transient from the previous frame dies here
+
+        if (!retiredSwapChains.empty())
+        {
+            retireCompletedSwapChains(); // cheap fence polls, frees old chains as frames drain
+        }
+
         auto result = paiSwapChain->acquireNextImage(&currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
@@ -96,9 +183,164 @@ namespace pai
         {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+
+        if (timestampQueryPool != VK_NULL_HANDLE)
+        {
+            // the fence wait in acquireNextImage guarantees this frame's old queries finished
+            resolveGpuScopes();
+            vkCmdResetQueryPool(
+                commandBuffer,
+                timestampQueryPool,
+                currentFrameIndex * MAX_GPU_SCOPES * 2,
+                MAX_GPU_SCOPES * 2);
+            gpuScopes[currentFrameIndex].clear();
+        }
         return commandBuffer;
     }
 
+    void PaiRenderer::resolveGpuScopes()
+    {
+        auto &scopes = gpuScopes[currentFrameIndex];
+        stats.gpuScopes.clear();
+        if (scopes.empty())
+        {
+            return;
+        }
+
+        uint32_t firstQuery = scopes.front().firstQuery;
+        uint32_t queryCount = static_cast<uint32_t>(scopes.size()) * 2;
+        FrameVector<uint64_t> results{queryCount, PaiFrameArenaAllocator<uint64_t>{frameArena}};
+        auto result = vkGetQueryPoolResults(
+            paiDevice.device(),
+            timestampQueryPool,
+            firstQuery,
+            queryCount,
+            results.size() * sizeof(uint64_t),
+            results.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < scopes.size(); i++)
+        {
+            GpuScopeStats scopeStats{};
+            scopeStats.name = scopes[i].name;
+            scopeStats.milliseconds =
+                (results[i * 2 + 1] - results[i * 2]) * timestampPeriod / 1000000.f;
+            stats.gpuScopes.push_back(scopeStats);
+        }
+    }
+
+    uint32_t PaiRenderer::beginGpuScope(VkCommandBuffer commandBuffer, const std::string &name)
+    {
+        assert(isFrameStarted && "Can't open a gpu scope when frame not in progress");
+        if (timestampQueryPool == VK_NULL_HANDLE)
+        {
+            return MAX_GPU_SCOPES; // no-op scope id
+        }
+
+        uint32_t firstQuery;
+        uint32_t scopeId;
+        {
+            // render jobs may open scopes from worker threads
+            std::lock_guard<std::mutex> lock{gpuScopeMutex};
+            auto &scopes = gpuScopes[currentFrameIndex];
+            if (scopes.size() >= MAX_GPU_SCOPES)
+            {
+                return MAX_GPU_SCOPES;
+            }
+            scopeId = static_cast<uint32_t>(scopes.size());
+            firstQuery = (currentFrameIndex * MAX_GPU_SCOPES + scopeId) * 2;
+            scopes.push_back({name, firstQuery});
+        }
+
+        vkCmdWriteTimestamp(
+            commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, firstQuery);
+        return scopeId;
+    }
+
+    void PaiRenderer::endGpuScope(VkCommandBuffer commandBuffer, uint32_t scopeId)
+    {
+        if (timestampQueryPool == VK_NULL_HANDLE)
+        {
+            return;
+        }
+        uint32_t firstQuery;
+        {
+            std::lock_guard<std::mutex> lock{gpuScopeMutex};
+            if (scopeId >= gpuScopes[currentFrameIndex].size())
+            {
+                return;
+            }
+            firstQuery = gpuScopes[currentFrameIndex][scopeId].firstQuery;
+        }
+        vkCmdWriteTimestamp(
+            commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, firstQuery + 1);
+    }
+
+    void PaiRenderer::recordFrameTime(float frameTime)
+    {
+        static constexpr size_t FRAME_TIME_WINDOW = 240;
+
+        float frameMs = frameTime * 1000.f;
+        if (frameTimeWindow.size() < FRAME_TIME_WINDOW)
+        {
+            frameTimeWindow.push_back(frameMs);
+        }
+        else
+        {
+            frameTimeWindow[frameTimeCursor] = frameMs;
+        }
+        frameTimeCursor = (frameTimeCursor + 1) % FRAME_TIME_WINDOW;
+
+        stats.cpuFrameMs = frameMs;
+        stats.cpuMinMs = frameTimeWindow[0];
+        stats.cpuMaxMs = frameTimeWindow[0];
+        stats.cpuHistogram.fill(0);
+        float total = 0.f;
+        for (float sample : frameTimeWindow)
+        {
+            total += sample;
+            stats.cpuMinMs = std::min(stats.cpuMinMs, sample);
+            stats.cpuMaxMs = std::max(stats.cpuMaxMs, sample);
+            auto bucket = std::min(
+                static_cast<uint32_t>(sample / RenderStats::FRAME_TIME_BUCKET_MS),
+                RenderStats::FRAME_TIME_BUCKET_COUNT - 1);
+            stats.cpuHistogram[bucket]++;
+        }
+        stats.cpuAvgMs = total / frameTimeWindow.size();
+    }
+
+    void PaiRenderer::dumpStatsCsv(const std::string &filepath) const
+    {
+        std::ofstream file{filepath, std::ios::trunc};
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+
+        file << "stat,value\n";
+        file << "cpu_frame_ms," << stats.cpuFrameMs << "\n";
+        file << "cpu_avg_ms," << stats.cpuAvgMs << "\n";
+        file << "cpu_min_ms," << stats.cpuMinMs << "\n";
+        file << "cpu_max_ms," << stats.cpuMaxMs << "\n";
+        file << "present_mode," << stats.presentMode << "\n";
+        file << "present_ms," << stats.presentMs << "\n";
+        file << "pacing_wait_ms," << stats.pacingWaitMs << "\n";
+        for (uint32_t i = 0; i < RenderStats::FRAME_TIME_BUCKET_COUNT; i++)
+        {
+            file << "cpu_hist_le_" << (i + 1) * RenderStats::FRAME_TIME_BUCKET_MS << "ms,"
+                 << stats.cpuHistogram[i] << "\n";
+        }
+        for (const auto &scope : stats.gpuScopes)
+        {
+            file << "gpu_" << scope.name << "_ms," << scope.milliseconds << "\n";
+        }
+    }
+
     void PaiRenderer::endFrame()
     {
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
@@ -108,7 +350,11 @@ namespace pai
             throw std::runtime_error("failed to record command buffer!");
         }
 
+        auto submitStart = std::chrono::steady_clock::now();
         auto result = paiSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        stats.presentMs = std::chrono::duration<float, std::milli>(
+                              std::chrono::steady_clock::now() - submitStart)
+                              .count();
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
             paiWindow.wasWindowResized())
         {
@@ -120,6 +366,20 @@ namespace pai
             throw std::runtime_error("failed to present swap chain image!");
         }
 
+        if (framePeriod != std::chrono::steady_clock::duration::zero())
+        {
+            auto beforeSleep = std::chrono::steady_clock::now();
+            if (beforeSleep < nextFrameDeadline)
+            {
+                std::this_thread::sleep_until(nextFrameDeadline);
+            }
+            auto afterSleep = std::chrono::steady_clock::now();
+            stats.pacingWaitMs =
+                std::chrono::duration<float, std::milli>(afterSleep - beforeSleep).count();
+            // a stall past the deadline resets the schedule instead of accumulating debt
+            nextFrameDeadline = std::max(nextFrameDeadline + framePeriod, afterSleep);
+        }
+
         isFrameStarted = false;
         currentFrameIndex = (currentFrameIndex + 1) % PaiSwapChain::MAX_FRAMES_IN_FLIGHT;
     }
@@ -145,6 +405,7 @@ namespace pai
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
+        renderPassScopeId = beginGpuScope(commandBuffer, "pass");
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
         VkViewport viewport{};
@@ -159,6 +420,144 @@ namespace pai
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
     }
 
+    PaiRenderer::SecondaryRecorder &PaiRenderer::getSecondaryRecorder(
+        int frameIndex, size_t jobIndex)
+    {
+        if (secondaryRecorders.empty())
+        {
+            secondaryRecorders.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+        auto &frameRecorders = secondaryRecorders[frameIndex];
+        if (jobIndex >= frameRecorders.size())
+        {
+            frameRecorders.resize(jobIndex + 1);
+        }
+
+        auto &recorder = frameRecorders[jobIndex];
+        if (recorder.pool == VK_NULL_HANDLE)
+        {
+            QueueFamilyIndices queueFamilyIndices = paiDevice.findPhysicalQueueFamilies();
+
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            if (vkCreateCommandPool(paiDevice.device(), &poolInfo, nullptr, &recorder.pool) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create secondary command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = recorder.pool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(paiDevice.device(), &allocInfo, &recorder.commandBuffer) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
+        }
+        else
+        {
+            // the frame fence has been waited on, the old recording is done
+            vkResetCommandPool(paiDevice.device(), recorder.pool, 0);
+        }
+        return recorder;
+    }
+
+    void PaiRenderer::renderParallel(
+        VkCommandBuffer commandBuffer, const std::vector<RenderJob> &jobs)
+    {
+        assert(isFrameStarted && "Can't call renderParallel if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't begin render pass on command buffer from a different frame");
+
+        // one secondary buffer per job, each recorded on its own worker with its own pool
+        FrameVector<VkCommandBuffer> secondaries{
+            jobs.size(), PaiFrameArenaAllocator<VkCommandBuffer>{frameArena}};
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            secondaries[i] = getSecondaryRecorder(currentFrameIndex, i).commandBuffer;
+        }
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = paiSwapChain->getRenderPass();
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = paiSwapChain->getFrameBuffer(currentImageIndex);
+
+        VkExtent2D extent = paiSwapChain->getSwapChainExtent();
+
+        FrameVector<std::future<void>> recordings{PaiFrameArenaAllocator<std::future<void>>{frameArena}};
+        recordings.reserve(jobs.size());
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            recordings.push_back(std::async(
+                std::launch::async,
+                [&, i]()
+                {
+                    VkCommandBufferBeginInfo beginInfo{};
+                    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                      VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                    beginInfo.pInheritanceInfo = &inheritanceInfo;
+                    if (vkBeginCommandBuffer(secondaries[i], &beginInfo) != VK_SUCCESS)
+                    {
+                        throw std::runtime_error("failed to begin recording command buffer!");
+                    }
+
+                    VkViewport viewport{};
+                    viewport.x = 0.0f;
+                    viewport.y = 0.0f;
+                    viewport.width = static_cast<float>(extent.width);
+                    viewport.height = static_cast<float>(extent.height);
+                    viewport.minDepth = 0.0f;
+                    viewport.maxDepth = 1.0f;
+                    VkRect2D scissor{{0, 0}, extent};
+                    vkCmdSetViewport(secondaries[i], 0, 1, &viewport);
+                    vkCmdSetScissor(secondaries[i], 0, 1, &scissor);
+
+                    jobs[i](secondaries[i]);
+
+                    if (vkEndCommandBuffer(secondaries[i]) != VK_SUCCESS)
+                    {
+                        throw std::runtime_error("failed to record command buffer!");
+                    }
+                }));
+        }
+        for (auto &recording : recordings)
+        {
+            recording.get();
+        }
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = paiSwapChain->getRenderPass();
+        renderPassInfo.framebuffer = paiSwapChain->getFrameBuffer(currentImageIndex);
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = extent;
+
+        std::array<VkClearValue, 2> clearValues{};
+        clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
+        clearValues[1].depthStencil = {1.0f, 0};
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+
+        renderPassScopeId = beginGpuScope(commandBuffer, "pass");
+        vkCmdBeginRenderPass(
+            commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        if (!secondaries.empty())
+        {
+            vkCmdExecuteCommands(
+                commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        }
+        vkCmdEndRenderPass(commandBuffer);
+        endGpuScope(commandBuffer, renderPassScopeId);
+    }
+
     void PaiRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer)
     {
         assert(isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress");
@@ -166,6 +565,7 @@ namespace pai
             commandBuffer == getCurrentCommandBuffer() &&
             "Can't end render pass on command buffer from a different frame");
         vkCmdEndRenderPass(commandBuffer);
+        endGpuScope(commandBuffer, renderPassScopeId);
     }
 
 }
\ No newline at end of file
@@ -1,16 +1,46 @@
 #pragma once
 
 #include "pai_device.hpp"
+#include "pai_frame_arena.hpp"
 #include "pai_swap_chain.hpp"
 #include "pai_window.hpp"
 
 // std
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace pai
 {
+
+    struct GpuScopeStats
+    {
+        std::string name;
+        float milliseconds = 0.f;
+    };
+
+    struct RenderStats
+    {
+        static constexpr uint32_t FRAME_TIME_BUCKET_COUNT = 16;
+        static constexpr float FRAME_TIME_BUCKET_MS = 2.f; // bucket width, last bucket is open-ended
+
+        float cpuFrameMs = 0.f; // most recent sample
+        float cpuAvgMs = 0.f;   // over the rolling window
+        float cpuMinMs = 0.f;
+        float cpuMaxMs = 0.f;
+        std::array<uint32_t, FRAME_TIME_BUCKET_COUNT> cpuHistogram{};
+        std::vector<GpuScopeStats> gpuScopes; // resolved MAX_FRAMES_IN_FLIGHT frames behind
+
+        std::string presentMode;  // what the swap chain actually got
+        float presentMs = 0.f;    // last submit + present call, includes any FIFO block
+        float pacingWaitMs = 0.f; // last sleep by the frame limiter, 0 when disabled
+    };
+
     class PaiRenderer
     {
     public:
@@ -21,6 +51,8 @@ namespace pai
         PaiRenderer &operator=(const PaiRenderer &) = delete;
 
         VkRenderPass getSwapChainRenderPass() const { return paiSwapChain->getRenderPass(); }
+        VkFormat getSwapChainImageFormat() { return paiSwapChain->getSwapChainImageFormat(); }
+        VkFormat getSwapChainDepthFormat() { return paiSwapChain->findDepthFormat(); }
         float getAspectRatio() const { return paiSwapChain->extentAspectRatio(); }
         bool isFrameInProgress() const { return isFrameStarted; }
 
@@ -36,21 +68,86 @@ namespace pai
             return currentFrameIndex;
         }
 
+        // Transient allocations with frame lifetime; reset at the top of beginFrame,
+        // so anything placed here must not outlive the frame. Main thread only.
+        PaiFrameArena &getFrameArena() { return frameArena; }
+
         VkCommandBuffer beginFrame();
         void endFrame();
         void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // Runs the whole swap chain render pass with each job recording its own
+        // secondary command buffer on a worker thread (one command pool per job slot
+        // per frame, since pools are not thread-safe). Jobs get a secondary buffer
+        // already inside the render pass with viewport and scissor set.
+        using RenderJob = std::function<void(VkCommandBuffer)>;
+        void renderParallel(VkCommandBuffer commandBuffer, const std::vector<RenderJob> &jobs);
+
+        // Rebuilds the swap chain with the new policy; FIFO remains the fallback when
+        // the surface doesn't offer the wanted mode. Call between frames only.
+        void setPresentPolicy(PaiSwapChain::PresentPolicy policy);
+        // Caps the frame rate by sleeping until the next deadline after present,
+        // independent of the present mode; 0 disables the limiter.
+        void setTargetFrameRate(float framesPerSecond);
+
+        // Instrumentation. Scopes bracket GPU work with timestamp queries; results show
+        // up in getStats() once the frame's fence has been waited on, so they lag by
+        // MAX_FRAMES_IN_FLIGHT frames.
+        uint32_t beginGpuScope(VkCommandBuffer commandBuffer, const std::string &name);
+        void endGpuScope(VkCommandBuffer commandBuffer, uint32_t scopeId);
+        void recordFrameTime(float frameTime);
+        const RenderStats &getStats() const { return stats; }
+        void dumpStatsCsv(const std::string &filepath) const;
+
     private:
         void createCommandBuffers();
         void freeCommandBuffers();
         void recreateSwapChain();
+        void retireCompletedSwapChains();
+        void createTimestampQueryPool();
+        void resolveGpuScopes();
 
         PaiWindow &paiWindow;
         PaiDevice &paiDevice;
         std::unique_ptr<PaiSwapChain> paiSwapChain;
+        // replaced swap chains waiting for their last frames' fences before destruction
+        std::vector<std::shared_ptr<PaiSwapChain>> retiredSwapChains;
         std::vector<VkCommandBuffer> commandBuffers;
 
+        static constexpr uint32_t MAX_GPU_SCOPES = 8; // per frame, two timestamps each
+
+        struct GpuScope
+        {
+            std::string name;
+            uint32_t firstQuery;
+        };
+
+        VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+        float timestampPeriod = 0.f;
+        std::vector<std::vector<GpuScope>> gpuScopes; // per frame in flight
+        std::mutex gpuScopeMutex;                     // jobs open scopes from workers
+        uint32_t renderPassScopeId = 0;
+
+        struct SecondaryRecorder
+        {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        };
+        std::vector<std::vector<SecondaryRecorder>> secondaryRecorders; // [frame][job]
+
+        SecondaryRecorder &getSecondaryRecorder(int frameIndex, size_t jobIndex);
+
+        PaiFrameArena frameArena;
+
+        RenderStats stats{};
+        std::vector<float> frameTimeWindow;
+        size_t frameTimeCursor = 0;
+
+        PaiSwapChain::PresentPolicy presentPolicy = PaiSwapChain::PresentPolicy::PreferMailbox;
+        std::chrono::steady_clock::duration framePeriod{};
+        std::chrono::steady_clock::time_point nextFrameDeadline{};
+
         uint32_t currentImageIndex{0};
         int currentFrameIndex{0};
         bool isFrameStarted{false};
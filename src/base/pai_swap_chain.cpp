@@ -9,19 +9,23 @@
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <utility>
 
 namespace pai
 {
 
-    PaiSwapChain::PaiSwapChain(PaiDevice &deviceRef, VkExtent2D extent)
-        : device{deviceRef}, windowExtent{extent}
+    PaiSwapChain::PaiSwapChain(PaiDevice &deviceRef, VkExtent2D extent, PresentPolicy presentPolicy)
+        : device{deviceRef}, windowExtent{extent}, presentPolicy{presentPolicy}
     {
         init();
     }
 
     PaiSwapChain::PaiSwapChain(
-        PaiDevice &deviceRef, VkExtent2D extent, std::shared_ptr<PaiSwapChain> previous)
-        : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous}
+        PaiDevice &deviceRef,
+        VkExtent2D extent,
+        std::shared_ptr<PaiSwapChain> previous,
+        PresentPolicy presentPolicy)
+        : device{deviceRef}, windowExtent{extent}, presentPolicy{presentPolicy}, oldSwapChain{previous}
     {
         init();
         oldSwapChain = nullptr;
@@ -31,14 +35,53 @@ namespace pai
     {
         createSwapChain();
         createImageViews();
-        createRenderPass();
-        createDepthResources();
+        bool sameFormats =
+            oldSwapChain != nullptr && oldSwapChain->swapChainImageFormat == swapChainImageFormat &&
+            oldSwapChain->swapChainDepthFormat == findDepthFormat();
+        if (sameFormats)
+        {
+            // the render pass only depends on attachment formats, so a resize can keep
+            // it; pipelines built against it stay valid across the recreation
+            renderPass = oldSwapChain->renderPass;
+            oldSwapChain->renderPass = VK_NULL_HANDLE;
+        }
+        else
+        {
+            createRenderPass();
+        }
+        if (sameFormats &&
+            oldSwapChain->swapChainExtent.width == swapChainExtent.width &&
+            oldSwapChain->swapChainExtent.height == swapChainExtent.height &&
+            oldSwapChain->depthImages.size() == imageCount())
+        {
+            // same extent (e.g. a present-policy rebuild): the depth images fit as-is
+            swapChainDepthFormat = oldSwapChain->swapChainDepthFormat;
+            depthImages = std::move(oldSwapChain->depthImages);
+            depthImageMemorys = std::move(oldSwapChain->depthImageMemorys);
+            depthImageViews = std::move(oldSwapChain->depthImageViews);
+            oldSwapChain->depthImages.clear();
+            oldSwapChain->depthImageMemorys.clear();
+            oldSwapChain->depthImageViews.clear();
+        }
+        else
+        {
+            createDepthResources();
+        }
         createFramebuffers();
         createSyncObjects();
     }
 
     PaiSwapChain::~PaiSwapChain()
     {
+        // retire against this chain's own frames instead of a device-wide idle; the
+        // fences start signaled, so a chain with nothing in flight destroys immediately
+        vkWaitForFences(
+            device.device(),
+            static_cast<uint32_t>(inFlightFences.size()),
+            inFlightFences.data(),
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max());
+
         for (auto imageView : swapChainImageViews)
         {
             vkDestroyImageView(device.device(), imageView, nullptr);
@@ -55,7 +98,7 @@ namespace pai
         {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
             vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.freeImageMemory(depthImageMemorys[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers)
@@ -63,7 +106,10 @@ namespace pai
             vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
         }
 
-        vkDestroyRenderPass(device.device(), renderPass, nullptr);
+        if (renderPass != VK_NULL_HANDLE)
+        {
+            vkDestroyRenderPass(device.device(), renderPass, nullptr);
+        }
 
         // cleanup synchronization objects
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
@@ -74,6 +120,18 @@ namespace pai
         }
     }
 
+    bool PaiSwapChain::framesInFlightComplete() const
+    {
+        for (auto fence : inFlightFences)
+        {
+            if (vkGetFenceStatus(device.device(), fence) != VK_SUCCESS)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
     VkResult PaiSwapChain::acquireNextImage(uint32_t *imageIndex)
     {
         vkWaitForFences(
@@ -427,24 +485,45 @@ namespace pai
     VkPresentModeKHR PaiSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR> &availablePresentModes)
     {
+        VkPresentModeKHR wanted = VK_PRESENT_MODE_FIFO_KHR;
+        switch (presentPolicy)
+        {
+        case PresentPolicy::PreferMailbox:
+            wanted = VK_PRESENT_MODE_MAILBOX_KHR;
+            break;
+        case PresentPolicy::Immediate:
+            wanted = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            break;
+        case PresentPolicy::VSync:
+            break;
+        }
+
+        presentMode = VK_PRESENT_MODE_FIFO_KHR; // always available
         for (const auto &availablePresentMode : availablePresentModes)
         {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+            if (availablePresentMode == wanted)
             {
-                std::cout << "Present mode: Mailbox" << std::endl;
-                return availablePresentMode;
+                presentMode = availablePresentMode;
+                break;
             }
         }
+        std::cout << "Present mode: " << presentModeName() << std::endl;
+        return presentMode;
+    }
 
-        // for (const auto &availablePresentMode : availablePresentModes) {
-        //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //     std::cout << "Present mode: Immediate" << std::endl;
-        //     return availablePresentMode;
-        //   }
-        // }
-
-        std::cout << "Present mode: V-Sync" << std::endl;
-        return VK_PRESENT_MODE_FIFO_KHR;
+    const char *PaiSwapChain::presentModeName() const
+    {
+        switch (presentMode)
+        {
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "mailbox";
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "immediate";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "fifo";
+        default:
+            return "other";
+        }
     }
 
     VkExtent2D PaiSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
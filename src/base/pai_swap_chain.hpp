@@ -15,6 +15,15 @@ namespace pai
 
     class PaiSwapChain
     {
+    public:
+        // How chooseSwapPresentMode picks among the surface's modes; FIFO is the
+        // guaranteed fallback in every case
+        enum class PresentPolicy
+        {
+            PreferMailbox, // low latency without tearing, falls back to FIFO
+            VSync,         // always FIFO, strict latency control
+            Immediate,     // uncapped throughput for measurement rigs, may tear
+        };
 
     private:
         void init();
@@ -47,6 +56,8 @@ namespace pai
 
         PaiDevice &device;
         VkExtent2D windowExtent;
+        PresentPolicy presentPolicy;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
         VkSwapchainKHR swapChain;
         std::shared_ptr<PaiSwapChain> oldSwapChain;
@@ -60,9 +71,15 @@ namespace pai
     public:
         static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
-        PaiSwapChain(PaiDevice &deviceRef, VkExtent2D windowExtent);
         PaiSwapChain(
-            PaiDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<PaiSwapChain> previous);
+            PaiDevice &deviceRef,
+            VkExtent2D windowExtent,
+            PresentPolicy presentPolicy = PresentPolicy::PreferMailbox);
+        PaiSwapChain(
+            PaiDevice &deviceRef,
+            VkExtent2D windowExtent,
+            std::shared_ptr<PaiSwapChain> previous,
+            PresentPolicy presentPolicy = PresentPolicy::PreferMailbox);
 
         ~PaiSwapChain();
 
@@ -74,6 +91,8 @@ namespace pai
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+        VkPresentModeKHR getPresentMode() { return presentMode; }
+        const char *presentModeName() const;
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
@@ -84,6 +103,11 @@ namespace pai
         }
         VkFormat findDepthFormat();
 
+        // True once every frame submitted through this chain has retired on the GPU.
+        // The fences start signaled, so a chain that never submitted reports complete;
+        // the destructor blocks on the same fences as a last resort.
+        bool framesInFlightComplete() const;
+
         VkResult acquireNextImage(uint32_t *imageIndex);
         VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
@@ -0,0 +1,66 @@
+#include "pai_transfer_batch.hpp"
+
+// std
+#include <cassert>
+
+namespace pai
+{
+
+    PaiTransferBatch::PaiTransferBatch(PaiDevice &device) : paiDevice{device}
+    {
+        commandBuffer = paiDevice.beginTransferCommands();
+    }
+
+    PaiTransferBatch::~PaiTransferBatch()
+    {
+        submit();
+    }
+
+    void PaiTransferBatch::upload(
+        const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+    {
+        assert(!submitted && "Cannot record into an already submitted batch");
+
+        auto staging = std::make_unique<PaiBuffer>(
+            paiDevice,
+            size,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        staging->map();
+        staging->writeToBuffer(const_cast<void *>(data), size);
+
+        copyBuffer(staging->getBuffer(), dstBuffer, size, 0, dstOffset);
+
+        // the staging buffer has to stay alive until the batch executes
+        stagingBuffers.push_back(std::move(staging));
+    }
+
+    void PaiTransferBatch::copyBuffer(
+        VkBuffer srcBuffer,
+        VkBuffer dstBuffer,
+        VkDeviceSize size,
+        VkDeviceSize srcOffset,
+        VkDeviceSize dstOffset)
+    {
+        assert(!submitted && "Cannot record into an already submitted batch");
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+    }
+
+    void PaiTransferBatch::submit()
+    {
+        if (submitted)
+        {
+            return;
+        }
+        paiDevice.submitTransferCommands(commandBuffer);
+        submitted = true;
+        stagingBuffers.clear();
+    }
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "pai_buffer.hpp"
+#include "pai_device.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace pai
+{
+
+    // Records many staging copies into one command buffer and submits them together
+    // behind a single fence, instead of one submit-and-wait round trip per copy.
+    class PaiTransferBatch
+    {
+    public:
+        PaiTransferBatch(PaiDevice &device);
+        ~PaiTransferBatch();
+
+        PaiTransferBatch(const PaiTransferBatch &) = delete;
+        PaiTransferBatch &operator=(const PaiTransferBatch &) = delete;
+
+        // stages data into a batch-owned buffer and records the copy; executed on submit
+        void upload(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+        void copyBuffer(
+            VkBuffer srcBuffer,
+            VkBuffer dstBuffer,
+            VkDeviceSize size,
+            VkDeviceSize srcOffset = 0,
+            VkDeviceSize dstOffset = 0);
+        void submit();
+
+    private:
+        PaiDevice &paiDevice;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        std::vector<std::unique_ptr<PaiBuffer>> stagingBuffers;
+        bool submitted = false;
+    };
+
+}
@@ -1,10 +1,12 @@
 #include "pai_window.hpp"
+#include "pai_input_queue.hpp"
 
 #include <stdexcept>
 
 namespace pai
 {
-    PaiWindow::PaiWindow(int w, int h, std::string name) : width{w}, height{h}, windowName{name}
+    PaiWindow::PaiWindow(int w, int h, std::string name, bool visible)
+        : width{w}, height{h}, visible{visible}, windowName{name}
     {
         initWindow();
     }
@@ -20,10 +22,12 @@ namespace pai
         glfwInit();
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+        glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
         window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
         glfwSetWindowUserPointer(window, this);
         glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+        glfwSetKeyCallback(window, keyCallback);
     }
 
     void PaiWindow::framebufferResizeCallback(GLFWwindow *window, int width, int height)
@@ -34,6 +38,16 @@ namespace pai
         paiWindow->height = height;
     }
 
+    void PaiWindow::keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods)
+    {
+        auto paiWindow = reinterpret_cast<PaiWindow *>(glfwGetWindowUserPointer(window));
+        if (paiWindow->inputQueue == nullptr || action == GLFW_REPEAT)
+        {
+            return;
+        }
+        paiWindow->inputQueue->push({key, action, glfwGetTime()});
+    }
+
     void PaiWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface)
     {
         if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
@@ -7,20 +7,25 @@
 
 namespace pai
 {
+    class PaiInputQueue;
+
     class PaiWindow
     {
     private:
         int width;
         int height;
         bool framebufferResized = false;
+        bool visible;
         std::string windowName;
         GLFWwindow *window;
+        PaiInputQueue *inputQueue = nullptr;
 
         static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
+        static void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
         void initWindow();
 
     public:
-        PaiWindow(int w, int h, std::string name);
+        PaiWindow(int w, int h, std::string name, bool visible = true);
         ~PaiWindow();
 
         PaiWindow(const PaiWindow &) = delete;
@@ -32,6 +37,9 @@ namespace pai
         bool wasWindowResized() { return framebufferResized; }
         void resetWindowResizedFlag() { framebufferResized = false; }
         GLFWwindow *getGLFWwindow() const { return window; }
+        // Routes key presses and releases into the queue from the GLFW key
+        // callback; pass nullptr to detach. The queue must outlive the attachment.
+        void attachInputQueue(PaiInputQueue *queue) { inputQueue = queue; }
         int getWidth() { return width; }
         int getHeight() { return height; }
     };
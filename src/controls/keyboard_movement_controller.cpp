@@ -6,15 +6,63 @@
 namespace pai
 {
 
-    glm::vec2 KeyboardMovementController::moveInPlaneXY(GLFWwindow *window, glm::vec2 state, glm::vec4 actions)
+    int KeyboardMovementController::directionFor(int key) const
     {
-        if (glfwGetKey(window, keys.moveForward) == GLFW_PRESS)
+        if (key == keys.moveLeft)
+            return LEFT;
+        if (key == keys.moveRight)
+            return RIGHT;
+        if (key == keys.moveForward)
+            return FORWARD;
+        if (key == keys.moveBackward)
+            return BACKWARD;
+        return -1;
+    }
+
+    bool KeyboardMovementController::consumeDirection(int direction)
+    {
+        if (held[direction])
+        {
+            // the press that set held also queued a tap; clear it so the key
+            // doesn't fire a second time after release
+            taps[direction] = 0;
+            return true;
+        }
+        if (taps[direction] > 0)
+        {
+            taps[direction]--;
+            return true;
+        }
+        return false;
+    }
+
+    glm::vec2 KeyboardMovementController::moveInPlaneXY(
+        PaiInputQueue &events, glm::vec2 state, glm::vec4 actions)
+    {
+        PaiInputQueue::KeyEvent event;
+        while (events.pop(event))
+        {
+            int direction = directionFor(event.key);
+            if (direction < 0)
+                continue;
+            if (event.action == GLFW_PRESS)
+            {
+                held[direction] = true;
+                taps[direction]++;
+            }
+            else if (event.action == GLFW_RELEASE)
+            {
+                held[direction] = false;
+            }
+        }
+
+        if (consumeDirection(FORWARD))
             state.y -= actions.z;
-        else if (glfwGetKey(window, keys.moveBackward) == GLFW_PRESS)
+        else if (consumeDirection(BACKWARD))
             state.y += actions.w;
-        else if (glfwGetKey(window, keys.moveRight) == GLFW_PRESS)
+        else if (consumeDirection(RIGHT))
             state.x += actions.y;
-        else if (glfwGetKey(window, keys.moveLeft) == GLFW_PRESS)
+        else if (consumeDirection(LEFT))
             state.x -= actions.x;
 
         return state;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../base/pai_input_queue.hpp"
 #include "../base/pai_window.hpp"
 #include "../pai_game_object.hpp"
 
@@ -23,10 +24,29 @@ namespace pai
         };
 
         void moveInPlaneXZ(GLFWwindow *window, float dt, PaiGameObject &gameObject);
-        glm::vec2 moveInPlaneXY(GLFWwindow *window, glm::vec2 state, glm::vec4 actions);
+        // Drains the event queue and applies at most one move, same priority as
+        // the old glfwGetKey chain. A tap pressed and released between two
+        // simulation steps still fires once instead of being lost to the poll.
+        glm::vec2 moveInPlaneXY(PaiInputQueue &events, glm::vec2 state, glm::vec4 actions);
 
         KeyMappings keys{};
         float moveSpeed{3.f};
         float lookSpeed{1.5f};
+
+    private:
+        enum Direction
+        {
+            LEFT = 0,
+            RIGHT,
+            FORWARD,
+            BACKWARD,
+            DIRECTION_COUNT
+        };
+
+        int directionFor(int key) const;
+        bool consumeDirection(int direction);
+
+        bool held[DIRECTION_COUNT]{};
+        uint32_t taps[DIRECTION_COUNT]{};
     };
 }
\ No newline at end of file
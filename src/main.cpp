@@ -3,15 +3,51 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main()
+int main(int argc, char **argv)
 {
+  uint32_t benchmarkFrames = 0;
+  bool continuous = false;
+  float simulationRate = 30.f;
+  std::string recordPath;
+  uint32_t agentCount = 1;
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::string(argv[i]) == "--benchmark" && i + 1 < argc)
+    {
+      benchmarkFrames = std::stoul(argv[++i]);
+    }
+    else if (std::string(argv[i]) == "--continuous")
+    {
+      continuous = true;
+    }
+    else if (std::string(argv[i]) == "--sim-rate" && i + 1 < argc)
+    {
+      simulationRate = std::stof(argv[++i]);
+    }
+    else if (std::string(argv[i]) == "--record" && i + 1 < argc)
+    {
+      recordPath = argv[++i];
+    }
+    else if (std::string(argv[i]) == "--agents" && i + 1 < argc)
+    {
+      agentCount = std::stoul(argv[++i]);
+    }
+  }
 
-  pai::PaiAppBase app{};
+  pai::PaiAppBase app{benchmarkFrames > 0};
 
   try
   {
-    app.run();
+    if (benchmarkFrames > 0)
+    {
+      app.runBenchmark(benchmarkFrames);
+    }
+    else
+    {
+      app.run(continuous, simulationRate, recordPath, agentCount);
+    }
   }
   catch (const std::exception &e)
   {
@@ -20,4 +56,4 @@ int main()
   }
 
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
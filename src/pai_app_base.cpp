@@ -1,8 +1,12 @@
 
 #include "pai_app_base.hpp"
 
+#include "base/pai_input_queue.hpp"
 #include "controls/keyboard_movement_controller.hpp"
+#include "pai_trajectory_recorder.hpp"
+#include "pai_world_file.hpp"
 
+#include "systems/grid_compute_system.hpp"
 #include "systems/simple_render_system.hpp"
 #include "systems/pixel_system.hpp"
 
@@ -13,55 +17,82 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <iostream>
+#include <numeric>
 #include <stdexcept>
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
 
 namespace pai
 {
 
-    PaiAppBase::PaiAppBase()
+    PaiAppBase::PaiAppBase(bool headless)
+        : paiWindow{WIDTH, HEIGHT, "Vulkan Tutorial", !headless}
     {
         globalPool =
             PaiDescriptorPool::Builder(paiDevice)
                 .setMaxSets(PaiSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, PaiSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, PaiSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, PaiSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .build();
         loadGameObjects();
     }
 
     PaiAppBase::~PaiAppBase() {}
 
-    void PaiAppBase::run()
+    void PaiAppBase::run(
+        bool continuous, float simulationRate, const std::string &recordPath, uint32_t agentCount)
     {
         glm::vec2 state = {0.f, 0.f};
         bool active = false;
-        std::vector<std::unique_ptr<PaiBuffer>> uboBuffers(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < uboBuffers.size(); i++)
-        {
-            uboBuffers[i] = std::make_unique<PaiBuffer>(
-                paiDevice,
-                sizeof(GlobalUbo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-            uboBuffers[i]->map();
-        }
+        auto pixel = registry.pixelRenderables().front().pixel;
+
+        // one allocation with an aligned slice per frame in flight; one descriptor
+        // set plus a dynamic offset selects the slice. The memory is non-coherent,
+        // so each slice must also sit on a nonCoherentAtomSize boundary for the
+        // per-index flushes to be valid
+        VkDeviceSize atomSize = paiDevice.properties.limits.nonCoherentAtomSize;
+        PaiBuffer globalUboBuffer{
+            paiDevice,
+            sizeof(GlobalUbo),
+            PaiSwapChain::MAX_FRAMES_IN_FLIGHT,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            std::lcm(paiDevice.properties.limits.minUniformBufferOffsetAlignment, atomSize)};
+        globalUboBuffer.map();
+
+        // one agent-occupancy flag per cell, sliced per frame in flight like the
+        // UBO; the shaders highlight every nonzero cell, so any number of agents
+        // costs one buffer write instead of one UBO update each
+        PaiBuffer agentGridBuffer{
+            paiDevice,
+            sizeof(uint32_t) * pixel->getCellCount(),
+            PaiSwapChain::MAX_FRAMES_IN_FLIGHT,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            std::lcm(paiDevice.properties.limits.minStorageBufferOffsetAlignment, atomSize)};
+        agentGridBuffer.map();
 
         auto globalSetLayout =
             PaiDescriptorSetLayout::Builder(paiDevice)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+                .addBinding(
+                    0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                .addBinding(
+                    1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
                 .build();
 
-        std::vector<VkDescriptorSet> globalDescriptorSets(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < globalDescriptorSets.size(); i++)
-        {
-            auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            PaiDescriptorWriter(*globalSetLayout, *globalPool)
-                .writeBuffer(0, &bufferInfo)
-                .build(globalDescriptorSets[i]);
-        }
+        VkDescriptorSet globalDescriptorSet;
+        auto bufferInfo = globalUboBuffer.descriptorInfoForIndex(0);
+        auto agentGridInfo = agentGridBuffer.descriptorInfoForIndex(0);
+        PaiDescriptorWriter(*globalSetLayout, *globalPool)
+            .writeBuffer(0, &bufferInfo)
+            .writeBuffer(1, &agentGridInfo)
+            .build(globalDescriptorSet);
 
         // SimpleRenderSystem simpleRenderSystem{
         //     paiDevice,
@@ -73,30 +104,152 @@ namespace pai
             paiRenderer.getSwapChainRenderPass(),
             globalSetLayout->getDescriptorSetLayout()};
 
+        GridComputeSystem gridComputeSystem{
+            paiDevice,
+            pixel->getStateBuffers(),
+            pixel->getStateBufferSize(),
+            pixel->getGridHeight()};
+
         PaiCamera camera{};
 
         auto viewerObject = PaiGameObject::createGameObject();
         viewerObject.transform.translation.z = -5.0f;
         // viewerObject.transform.translation.x = -0.2f;
         KeyboardMovementController cameraController{};
+        // key presses land here from the GLFW callback as they arrive, so a tap
+        // during a long frame still reaches the next simulation step
+        PaiInputQueue inputQueue{};
+        paiWindow.attachInputQueue(&inputQueue);
+
+        std::unique_ptr<PaiTrajectoryRecorder> recorder;
+        if (!recordPath.empty())
+        {
+            recorder = std::make_unique<PaiTrajectoryRecorder>(recordPath);
+        }
+
+        const float fixedTimestep = 1.f / simulationRate;
+        float accumulator = 0.f;
+        uint32_t simulationFrame = 0;
+
+        // multi-agent mode: a contiguous agent array stepped in bulk each tick;
+        // agent 0 stays under keyboard control, the rest random-walk the maze
+        const bool multiAgent = agentCount > 1;
+        std::vector<glm::vec2> agents(multiAgent ? agentCount : 1, state);
+        uint32_t cellCount = pixel->getCellCount();
+        int gridHeight = pixel->getGridHeight();
+        for (uint32_t i = 1; i < agents.size(); i++)
+        {
+            uint32_t cell = static_cast<uint32_t>((static_cast<uint64_t>(i) * cellCount) / agents.size());
+            agents[i] = {static_cast<float>(cell / gridHeight), static_cast<float>(cell % gridHeight)};
+        }
+        std::vector<glm::vec2> previousAgents = agents;
+        std::vector<glm::ivec2> agentCells;
+        std::vector<glm::vec4> agentActions;
+        uint32_t rngState = 0x9E3779B9u;
+        auto nextRand = [&rngState]()
+        {
+            rngState ^= rngState << 13;
+            rngState ^= rngState >> 17;
+            rngState ^= rngState << 5;
+            return rngState;
+        };
+
+        std::vector<uint32_t> agentFlags(cellCount, 0u);
+
+        glm::vec2 previousState = state;
+        auto stepSimulation = [&]()
+        {
+            previousState = state;
+            glm::vec4 actions = pixel->getActions(state);
+            if (recorder)
+            {
+                recorder->record({simulationFrame, fixedTimestep, state, actions});
+            }
+            // the visual update runs on the GPU; the CPU only keeps the world in sync
+            gridComputeSystem.queueUpdate(glm::ivec2(state), 1);
+            pixel->addStateLocal(state);
+            state = cameraController.moveInPlaneXY(inputQueue, state, actions);
+            agents[0] = state;
+            previousAgents[0] = previousState;
+
+            if (multiAgent)
+            {
+                // one pass over the flat cell array answers every agent at once
+                previousAgents = agents;
+                previousAgents[0] = previousState;
+                agentCells.resize(agents.size());
+                for (size_t i = 0; i < agents.size(); i++)
+                {
+                    agentCells[i] = glm::ivec2(agents[i]);
+                }
+                pixel->getActions(agentCells, agentActions);
+                for (size_t i = 1; i < agents.size(); i++)
+                {
+                    if (recorder)
+                    {
+                        recorder->record({simulationFrame, fixedTimestep, agents[i], agentActions[i]});
+                    }
+                    glm::vec2 moves[4] = {{-1.f, 0.f}, {1.f, 0.f}, {0.f, -1.f}, {0.f, 1.f}};
+                    int allowed[4];
+                    int allowedCount = 0;
+                    for (int d = 0; d < 4; d++)
+                    {
+                        if (agentActions[i][d] != 0.f)
+                        {
+                            allowed[allowedCount++] = d;
+                        }
+                    }
+                    if (allowedCount == 0)
+                    {
+                        continue; // boxed in; the cell stays occupied
+                    }
+                    // cells visited by any agent become walls, so the walk spreads
+                    pixel->addState(agents[i]);
+                    agents[i] += moves[allowed[nextRand() % allowedCount]];
+                }
+            }
+            simulationFrame++;
+        };
 
         auto currentTime = std::chrono::high_resolution_clock::now();
         while (!paiWindow.shouldClose())
         {
-            // glfwPollEvents();
-            glfwWaitEvents();
+            if (continuous)
+            {
+                glfwPollEvents();
+            }
+            else
+            {
+                glfwWaitEvents();
+            }
 
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime =
                 std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
+            paiRenderer.recordFrameTime(frameTime);
 
             // cameraController.moveInPlaneXZ(paiWindow.getGLFWwindow(), frameTime, viewerObject);
-            
-            glm::vec4 actions = gameObjects.begin()->second.pixel->getActions(state);
-            gameObjects.begin()->second.pixel->addState(state);
-            state = cameraController.moveInPlaneXY(paiWindow.getGLFWwindow(), state, actions);
-            
+
+            float alpha = 1.f;
+            if (continuous)
+            {
+                // fixed-timestep accumulator: the simulation always steps by
+                // fixedTimestep regardless of display rate; cap the catch-up so a
+                // stall (window drag, swap chain rebuild) can't spiral
+                accumulator += glm::min(frameTime, 4.f * fixedTimestep);
+                while (accumulator >= fixedTimestep)
+                {
+                    stepSimulation();
+                    accumulator -= fixedTimestep;
+                }
+                alpha = accumulator / fixedTimestep;
+            }
+            else
+            {
+                stepSimulation();
+            }
+
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
 
             float aspect = paiRenderer.getAspectRatio();
@@ -110,28 +263,352 @@ namespace pai
                     frameTime,
                     commandBuffer,
                     camera,
-                    globalDescriptorSets[frameIndex],
-                    gameObjects};
+                    globalDescriptorSet,
+                    static_cast<uint32_t>(frameIndex * globalUboBuffer.getAlignmentSize()),
+                    static_cast<uint32_t>(frameIndex * agentGridBuffer.getAlignmentSize()),
+                    registry,
+                    &paiRenderer};
 
                 // update
                 GlobalUbo ubo{};
-                ubo.agent = state;
+                // the agent lives on discrete grid cells, so interpolation between the
+                // last two simulation states snaps to the nearest cell mid-step
+                ubo.agent = glm::round(glm::mix(previousState, state, alpha));
                 // ubo.projection = camera.getProjection();
                 // ubo.view = camera.getView();
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
+                globalUboBuffer.writeToIndex(&ubo, frameIndex);
+                globalUboBuffer.flushIndex(frameIndex);
 
-                // render
-                paiRenderer.beginSwapChainRenderPass(commandBuffer);
-                // simpleRenderSystem.render(frameInfo);
-                pixelSystem.render(frameInfo);
+                // rebuild this frame's agent-occupancy slice; the shaders highlight
+                // every flagged cell, however many agents share the world
+                std::fill(agentFlags.begin(), agentFlags.end(), 0u);
+                for (size_t i = 0; i < agents.size(); i++)
+                {
+                    glm::vec2 cell = glm::round(glm::mix(previousAgents[i], agents[i], alpha));
+                    uint32_t index =
+                        static_cast<uint32_t>(cell.x) * gridHeight + static_cast<uint32_t>(cell.y);
+                    if (index < cellCount)
+                    {
+                        agentFlags[index] = 1u;
+                    }
+                }
+                agentGridBuffer.writeToIndex(agentFlags.data(), frameIndex);
+                agentGridBuffer.flushIndex(frameIndex);
 
-                paiRenderer.endSwapChainRenderPass(commandBuffer);
+                // upload CPU-side cell edits and apply queued compute updates to this
+                // frame's buffer version before the render pass reads it
+                pixel->flushPending(commandBuffer, frameIndex);
+                gridComputeSystem.dispatch(commandBuffer, frameIndex);
+                // refresh the shared vertex buffer for the batched indirect draw
+                pixelSystem.updateBatch(frameInfo);
+
+                // render, each system recording its secondary buffer on a worker
+                paiRenderer.renderParallel(
+                    commandBuffer,
+                    {
+                        // [&](VkCommandBuffer secondary)
+                        // {
+                        //     FrameInfo jobFrame = frameInfo;
+                        //     jobFrame.commandBuffer = secondary;
+                        //     simpleRenderSystem.render(jobFrame);
+                        // },
+                        [&](VkCommandBuffer secondary)
+                        {
+                            FrameInfo jobFrame = frameInfo;
+                            jobFrame.commandBuffer = secondary;
+                            pixelSystem.renderBatched(jobFrame);
+                        },
+                    });
                 paiRenderer.endFrame();
             }
         }
 
+        paiWindow.attachInputQueue(nullptr); // the queue dies with this scope
+        vkDeviceWaitIdle(paiDevice.device());
+        paiRenderer.dumpStatsCsv(ENGINE_DIR "render_stats.csv");
+        if (recorder && recorder->droppedRecords() > 0)
+        {
+            std::cout << "trajectory recorder dropped " << recorder->droppedRecords()
+                      << " records\n";
+        }
+    }
+
+    void PaiAppBase::runBenchmark(uint32_t frameCount)
+    {
+        auto pixel = registry.pixelRenderables().front().pixel;
+
+        auto uboBuffer = std::make_unique<PaiBuffer>(
+            paiDevice,
+            sizeof(GlobalUbo),
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        uboBuffer->map();
+
+        auto agentGridBuffer = std::make_unique<PaiBuffer>(
+            paiDevice,
+            sizeof(uint32_t) * pixel->getCellCount(),
+            1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        agentGridBuffer->map();
+
+        auto globalSetLayout =
+            PaiDescriptorSetLayout::Builder(paiDevice)
+                .addBinding(
+                    0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                .addBinding(
+                    1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                .build();
+
+        VkDescriptorSet globalDescriptorSet;
+        auto bufferInfo = uboBuffer->descriptorInfo();
+        auto agentGridInfo = agentGridBuffer->descriptorInfo();
+        PaiDescriptorWriter(*globalSetLayout, *globalPool)
+            .writeBuffer(0, &bufferInfo)
+            .writeBuffer(1, &agentGridInfo)
+            .build(globalDescriptorSet);
+
+        PixelSystem pixelSystem{
+            paiDevice,
+            paiRenderer.getSwapChainRenderPass(),
+            globalSetLayout->getDescriptorSetLayout()};
+
+        // offscreen color and depth targets on the swap chain's render pass
+        VkExtent2D extent{WIDTH, HEIGHT};
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = paiRenderer.getSwapChainImageFormat();
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkImage colorImage;
+        VkDeviceMemory colorImageMemory;
+        paiDevice.createImageWithInfo(
+            imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory);
+
+        imageInfo.format = paiRenderer.getSwapChainDepthFormat();
+        imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+        VkImage depthImage;
+        VkDeviceMemory depthImageMemory;
+        paiDevice.createImageWithInfo(
+            imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = colorImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = paiRenderer.getSwapChainImageFormat();
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        VkImageView colorImageView;
+        if (vkCreateImageView(paiDevice.device(), &viewInfo, nullptr, &colorImageView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create benchmark image view!");
+        }
+
+        viewInfo.image = depthImage;
+        viewInfo.format = paiRenderer.getSwapChainDepthFormat();
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+        VkImageView depthImageView;
+        if (vkCreateImageView(paiDevice.device(), &viewInfo, nullptr, &depthImageView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create benchmark image view!");
+        }
+
+        std::array<VkImageView, 2> attachments = {colorImageView, depthImageView};
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = paiRenderer.getSwapChainRenderPass();
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(paiDevice.device(), &framebufferInfo, nullptr, &framebuffer) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create benchmark framebuffer!");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = paiDevice.getCommandPool();
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(paiDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence frameFence;
+        if (vkCreateFence(paiDevice.device(), &fenceInfo, nullptr, &frameFence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create benchmark fence!");
+        }
+
+        PaiCamera camera{};
+        camera.setPerspectiveProjection(
+            glm::radians(120.f), static_cast<float>(WIDTH) / HEIGHT, 0.01f, 25.f);
+
+        glm::vec2 state{0.f, 0.f};
+        std::vector<uint32_t> agentFlags(pixel->getCellCount(), 0u);
+
+        double updateSeconds = 0.0;
+        double recordSeconds = 0.0;
+        double gpuSeconds = 0.0;
+        auto benchStart = std::chrono::high_resolution_clock::now();
+
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            auto updateStart = std::chrono::high_resolution_clock::now();
+
+            // serpentine sweep across the grid so the world update and dirty-region
+            // uploads see a new cell every frame, same as an agent walking the maze
+            pixel->getActions(state);
+            pixel->addState(state);
+            if (static_cast<int>(state.x) % 2 == 0)
+            {
+                state.y += 1.f;
+            }
+            else
+            {
+                state.y -= 1.f;
+            }
+            if (state.y > 23.f || state.y < 0.f)
+            {
+                state.y = glm::clamp(state.y, 0.f, 23.f);
+                state.x += 1.f;
+            }
+            if (state.x > 23.f)
+            {
+                state = {0.f, 0.f};
+            }
+
+            GlobalUbo ubo{};
+            ubo.agent = state;
+            uboBuffer->writeToBuffer(&ubo);
+            uboBuffer->flush();
+
+            std::fill(agentFlags.begin(), agentFlags.end(), 0u);
+            agentFlags[static_cast<uint32_t>(state.x) * pixel->getGridHeight() +
+                       static_cast<uint32_t>(state.y)] = 1u;
+            agentGridBuffer->writeToBuffer(agentFlags.data());
+            agentGridBuffer->flush();
+
+            auto recordStart = std::chrono::high_resolution_clock::now();
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to begin recording command buffer!");
+            }
+
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = paiRenderer.getSwapChainRenderPass();
+            renderPassInfo.framebuffer = framebuffer;
+            renderPassInfo.renderArea.offset = {0, 0};
+            renderPassInfo.renderArea.extent = extent;
+
+            std::array<VkClearValue, 2> clearValues{};
+            clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
+            clearValues[1].depthStencil = {1.0f, 0};
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            renderPassInfo.pClearValues = clearValues.data();
+
+            // single buffer version in flight here: the fence below serializes frames
+            pixel->flushPending(commandBuffer, 0);
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+            VkViewport viewport{};
+            viewport.width = static_cast<float>(extent.width);
+            viewport.height = static_cast<float>(extent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            VkRect2D scissor{{0, 0}, extent};
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+            FrameInfo frameInfo{
+                0,
+                0.f,
+                commandBuffer,
+                camera,
+                globalDescriptorSet,
+                0,
+                0,
+                registry};
+            pixelSystem.render(frameInfo);
+
+            vkCmdEndRenderPass(commandBuffer);
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to record command buffer!");
+            }
+
+            auto submitStart = std::chrono::high_resolution_clock::now();
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            if (vkQueueSubmit(paiDevice.graphicsQueue(), 1, &submitInfo, frameFence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit benchmark command buffer!");
+            }
+            vkWaitForFences(paiDevice.device(), 1, &frameFence, VK_TRUE, UINT64_MAX);
+            vkResetFences(paiDevice.device(), 1, &frameFence);
+
+            auto frameEnd = std::chrono::high_resolution_clock::now();
+            updateSeconds += std::chrono::duration<double>(recordStart - updateStart).count();
+            recordSeconds += std::chrono::duration<double>(submitStart - recordStart).count();
+            gpuSeconds += std::chrono::duration<double>(frameEnd - submitStart).count();
+        }
+
+        auto benchEnd = std::chrono::high_resolution_clock::now();
+        double totalSeconds = std::chrono::duration<double>(benchEnd - benchStart).count();
+
+        std::cout << "benchmark: " << frameCount << " frames in " << totalSeconds << " s ("
+                  << frameCount / totalSeconds << " fps)\n";
+        std::cout << "  update: " << updateSeconds / frameCount * 1000.0 << " ms/frame\n";
+        std::cout << "  record: " << recordSeconds / frameCount * 1000.0 << " ms/frame\n";
+        std::cout << "  submit+gpu: " << gpuSeconds / frameCount * 1000.0 << " ms/frame\n";
+
         vkDeviceWaitIdle(paiDevice.device());
+
+        vkDestroyFence(paiDevice.device(), frameFence, nullptr);
+        vkFreeCommandBuffers(paiDevice.device(), paiDevice.getCommandPool(), 1, &commandBuffer);
+        vkDestroyFramebuffer(paiDevice.device(), framebuffer, nullptr);
+        vkDestroyImageView(paiDevice.device(), depthImageView, nullptr);
+        vkDestroyImageView(paiDevice.device(), colorImageView, nullptr);
+        vkDestroyImage(paiDevice.device(), depthImage, nullptr);
+        paiDevice.freeImageMemory(depthImageMemory);
+        vkDestroyImage(paiDevice.device(), colorImage, nullptr);
+        paiDevice.freeImageMemory(colorImageMemory);
     }
 
     std::unique_ptr<PaiModel> createSquareModel(PaiDevice &device, glm::vec3 offset)
@@ -425,11 +902,24 @@ namespace pai
         //                                 {23, 20},
         //                                 {23, 21},
         //                                 {23, 22}};
-        std::vector<glm::vec2> walls{};
-        auto pixel = std::make_shared<PaiPixel>(paiDevice, 24, 24, walls);
-        auto grid = PaiGameObject::createGameObject();
-        grid.pixel = pixel;
+        auto grid = registry.create();
+
+        // a generated world next to the binary wins over the built-in empty grid;
+        // the mapped bitmap initializes world and vertex states in one pass
+        try
+        {
+            PaiWorldFile worldFile{ENGINE_DIR "world.pwld"};
+            std::cout << "loaded world " << worldFile.getHeight() << "x" << worldFile.getWidth()
+                      << " from " << ENGINE_DIR "world.pwld" << std::endl;
+            registry.setPixel(grid, std::make_shared<PaiPixel>(paiDevice, worldFile));
+            return;
+        }
+        catch (const std::runtime_error &)
+        {
+            // no world file; fall back to the default grid
+        }
 
-        gameObjects.emplace(grid.getId(), std::move(grid));
+        std::vector<glm::vec2> walls{};
+        registry.setPixel(grid, std::make_shared<PaiPixel>(paiDevice, 24, 24, walls));
     }
 } // namespace pai
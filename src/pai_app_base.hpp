@@ -6,10 +6,11 @@
 #include "base/pai_renderer.hpp"
 #include "base/pai_window.hpp"
 #include "base/pai_device.hpp"
-#include "pai_game_object.hpp"
+#include "pai_game_object_registry.hpp"
 
 // std
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace pai
@@ -20,13 +21,28 @@ namespace pai
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 800;
 
-        PaiAppBase();
+        PaiAppBase(bool headless = false);
         ~PaiAppBase();
 
         PaiAppBase(const PaiAppBase &) = delete;
         PaiAppBase &operator=(const PaiAppBase &) = delete;
 
-        void run();
+        // Event-driven by default (frames only on input). Continuous mode polls
+        // events, renders at display rate and steps the simulation on a fixed
+        // accumulator at simulationRate Hz, which also makes frame timings
+        // reproducible for benchmarking. A non-empty recordPath streams every
+        // simulation step into a binary trajectory log for offline training.
+        // agentCount > 1 steps that many agents in bulk against the shared world;
+        // agent 0 stays on the keyboard, the rest random-walk.
+        void run(
+            bool continuous = false,
+            float simulationRate = 30.f,
+            const std::string &recordPath = {},
+            uint32_t agentCount = 1);
+        // Renders a fixed number of frames into an offscreen framebuffer with a scripted
+        // agent path, no swap chain or input involved. Prints frames/sec and per-stage
+        // timings; pair with the headless constructor flag on machines without a display.
+        void runBenchmark(uint32_t frameCount);
 
     private:
         void loadGameObjects();
@@ -37,6 +53,6 @@ namespace pai
 
         // note: order of declarations matters
         std::unique_ptr<PaiDescriptorPool> globalPool{};
-        PaiGameObject::Map gameObjects;
+        PaiGameObjectRegistry registry;
     };
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "base/pai_camera.hpp"
-#include "pai_game_object.hpp"
+#include "pai_game_object_registry.hpp"
 
 // lib
 #include <vulkan/vulkan.h>
@@ -20,6 +20,8 @@ namespace pai
         glm::vec2 agent{};
     };
 
+    class PaiRenderer;
+
     struct FrameInfo
     {
         int frameIndex;
@@ -27,6 +29,9 @@ namespace pai
         VkCommandBuffer commandBuffer;
         PaiCamera &camera;
         VkDescriptorSet globalDescriptorSet;
-        PaiGameObject::Map &gameObjects;
+        uint32_t globalUboOffset = 0;   // dynamic offset of this frame's slice in the shared UBO
+        uint32_t agentGridOffset = 0;   // dynamic offset of this frame's agent-flag slice
+        PaiGameObjectRegistry &registry;
+        PaiRenderer *renderer = nullptr; // instrumentation scopes, may be null
     };
 } // namespace pai
@@ -0,0 +1,84 @@
+#include "pai_game_object_registry.hpp"
+
+// std
+#include <cassert>
+
+namespace pai
+{
+
+    PaiGameObjectRegistry::id_t PaiGameObjectRegistry::create()
+    {
+        id_t id = nextId++;
+        idToIndex[id] = ids.size();
+        ids.push_back(id);
+        transforms.emplace_back();
+        transforms2d.emplace_back();
+        colors.emplace_back();
+        models.emplace_back();
+        pixels.emplace_back();
+        refreshViews();
+        return id;
+    }
+
+    void PaiGameObjectRegistry::destroy(id_t id)
+    {
+        size_t index = indexOf(id);
+        size_t last = ids.size() - 1;
+        if (index != last)
+        {
+            // swap-and-pop keeps the arrays dense; only the moved id changes index
+            ids[index] = ids[last];
+            transforms[index] = transforms[last];
+            transforms2d[index] = transforms2d[last];
+            colors[index] = colors[last];
+            models[index] = std::move(models[last]);
+            pixels[index] = std::move(pixels[last]);
+            idToIndex[ids[index]] = index;
+        }
+        ids.pop_back();
+        transforms.pop_back();
+        transforms2d.pop_back();
+        colors.pop_back();
+        models.pop_back();
+        pixels.pop_back();
+        idToIndex.erase(id);
+        refreshViews();
+    }
+
+    size_t PaiGameObjectRegistry::indexOf(id_t id) const
+    {
+        auto it = idToIndex.find(id);
+        assert(it != idToIndex.end() && "Game object id not in registry");
+        return it->second;
+    }
+
+    void PaiGameObjectRegistry::setModel(id_t id, std::shared_ptr<PaiModel> model)
+    {
+        models[indexOf(id)] = std::move(model);
+        refreshViews();
+    }
+
+    void PaiGameObjectRegistry::setPixel(id_t id, std::shared_ptr<PaiPixel> pixel)
+    {
+        pixels[indexOf(id)] = std::move(pixel);
+        refreshViews();
+    }
+
+    void PaiGameObjectRegistry::refreshViews()
+    {
+        modelView.clear();
+        pixelView.clear();
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            if (models[i] != nullptr)
+            {
+                modelView.push_back({models[i].get(), &transforms[i]});
+            }
+            if (pixels[i] != nullptr)
+            {
+                pixelView.push_back({pixels[i].get()});
+            }
+        }
+    }
+
+}
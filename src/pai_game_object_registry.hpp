@@ -0,0 +1,72 @@
+#pragma once
+
+#include "pai_game_object.hpp"
+
+// std
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace pai
+{
+
+    // Dense storage for game objects: one contiguous array per component plus a
+    // stable-id-to-index map. Systems iterate the packed render views instead of
+    // hashing through PaiGameObject::Map and skipping objects without their
+    // component. Views are rebuilt on mutation, so the pointers they hold stay
+    // valid until the next create/destroy/set call.
+    class PaiGameObjectRegistry
+    {
+    public:
+        using id_t = PaiGameObject::id_t;
+
+        struct ModelRenderable
+        {
+            PaiModel *model;
+            TransformComponent *transform;
+        };
+
+        struct PixelRenderable
+        {
+            PaiPixel *pixel;
+        };
+
+        PaiGameObjectRegistry() = default;
+        PaiGameObjectRegistry(const PaiGameObjectRegistry &) = delete;
+        PaiGameObjectRegistry &operator=(const PaiGameObjectRegistry &) = delete;
+
+        id_t create();
+        void destroy(id_t id);
+        size_t size() const { return ids.size(); }
+
+        TransformComponent &transform(id_t id) { return transforms[indexOf(id)]; }
+        Transform2dComponent &transform2d(id_t id) { return transforms2d[indexOf(id)]; }
+        glm::vec3 &color(id_t id) { return colors[indexOf(id)]; }
+        const std::shared_ptr<PaiModel> &model(id_t id) { return models[indexOf(id)]; }
+        const std::shared_ptr<PaiPixel> &pixel(id_t id) { return pixels[indexOf(id)]; }
+
+        void setModel(id_t id, std::shared_ptr<PaiModel> model);
+        void setPixel(id_t id, std::shared_ptr<PaiPixel> pixel);
+
+        const std::vector<ModelRenderable> &modelRenderables() const { return modelView; }
+        const std::vector<PixelRenderable> &pixelRenderables() const { return pixelView; }
+
+    private:
+        size_t indexOf(id_t id) const;
+        void refreshViews();
+
+        // index-aligned component arrays, ids[i] owns the i-th entry of each
+        std::vector<id_t> ids;
+        std::vector<TransformComponent> transforms;
+        std::vector<Transform2dComponent> transforms2d;
+        std::vector<glm::vec3> colors;
+        std::vector<std::shared_ptr<PaiModel>> models;
+        std::vector<std::shared_ptr<PaiPixel>> pixels;
+        std::unordered_map<id_t, size_t> idToIndex;
+        id_t nextId = 0;
+
+        std::vector<ModelRenderable> modelView;
+        std::vector<PixelRenderable> pixelView;
+    };
+
+}
@@ -1,5 +1,6 @@
 #include "pai_model.hpp"
 
+#include "base/pai_mapped_file.hpp"
 #include "pai_utils.hpp"
 
 // libs
@@ -11,6 +12,9 @@
 // std
 #include <cassert>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <unordered_map>
 #ifndef ENGINE_DIR
 #define ENGINE_DIR "../"
@@ -35,8 +39,11 @@ namespace pai
 
     PaiModel::PaiModel(PaiDevice &device, const PaiModel::Builder &builder) : paiDevice{device}
     {
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
+        // one batch so vertex and index uploads share a single submit and fence wait
+        PaiTransferBatch batch{device};
+        createVertexBuffers(batch, builder.vertices);
+        createIndexBuffers(batch, builder.indices);
+        batch.submit();
     }
 
     PaiModel::~PaiModel() {}
@@ -49,24 +56,13 @@ namespace pai
         return std::make_unique<PaiModel>(device, builder);
     }
 
-    void PaiModel::createVertexBuffers(const std::vector<Vertex> &vertices)
+    void PaiModel::createVertexBuffers(PaiTransferBatch &batch, const std::vector<Vertex> &vertices)
     {
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
         uint32_t vertexSize = sizeof(vertices[0]);
 
-        PaiBuffer stagingBuffer{
-            paiDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-
         vertexBuffer = std::make_unique<PaiBuffer>(
             paiDevice,
             vertexSize,
@@ -74,10 +70,10 @@ namespace pai
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-        paiDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        batch.upload(vertices.data(), bufferSize, vertexBuffer->getBuffer());
     }
 
-    void PaiModel::createIndexBuffers(const std::vector<uint32_t> &indices)
+    void PaiModel::createIndexBuffers(PaiTransferBatch &batch, const std::vector<uint32_t> &indices)
     {
         indexCount = static_cast<uint32_t>(indices.size());
         hasIndexBuffer = indexCount > 0;
@@ -90,17 +86,6 @@ namespace pai
         VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
         uint32_t indexSize = sizeof(indices[0]);
 
-        PaiBuffer stagingBuffer{
-            paiDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
-
         indexBuffer = std::make_unique<PaiBuffer>(
             paiDevice,
             indexSize,
@@ -108,7 +93,7 @@ namespace pai
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-        paiDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        batch.upload(indices.data(), bufferSize, indexBuffer->getBuffer());
     }
 
     void PaiModel::draw(VkCommandBuffer commandBuffer)
@@ -156,8 +141,95 @@ namespace pai
         return attributeDescriptions;
     }
 
+    namespace
+    {
+        // binary sidecar with the deduplicated arrays, laid out header-then-raw-data
+        // so it can be memory-mapped and handed straight to the buffer upload
+        constexpr uint32_t MESH_CACHE_MAGIC = 0x48534D50; // "PMSH"
+        constexpr uint32_t MESH_CACHE_VERSION = 1;
+
+        struct MeshCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t vertexCount;
+            uint64_t indexCount;
+        };
+    } // namespace
+
+    bool PaiModel::Builder::loadMeshCache(const std::string &cachePath)
+    {
+        std::unique_ptr<PaiMappedFile> file;
+        try
+        {
+            file = std::make_unique<PaiMappedFile>(cachePath);
+        }
+        catch (const std::runtime_error &)
+        {
+            return false;
+        }
+
+        if (file->size() < sizeof(MeshCacheHeader))
+        {
+            return false;
+        }
+        MeshCacheHeader header{};
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION)
+        {
+            return false;
+        }
+        size_t expectedSize = sizeof(header) + header.vertexCount * sizeof(Vertex) +
+                              header.indexCount * sizeof(uint32_t);
+        if (file->size() != expectedSize)
+        {
+            return false;
+        }
+
+        // the arrays come straight out of the page-cache-backed mapping
+        vertices.resize(header.vertexCount);
+        indices.resize(header.indexCount);
+        std::memcpy(
+            vertices.data(), file->data() + sizeof(header), header.vertexCount * sizeof(Vertex));
+        std::memcpy(
+            indices.data(),
+            file->data() + sizeof(header) + header.vertexCount * sizeof(Vertex),
+            header.indexCount * sizeof(uint32_t));
+        return true;
+    }
+
+    void PaiModel::Builder::writeMeshCache(const std::string &cachePath)
+    {
+        std::ofstream file{cachePath, std::ios::binary | std::ios::trunc};
+        if (!file.is_open())
+        {
+            return; // read-only asset dir, cache is best effort
+        }
+
+        MeshCacheHeader header{};
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        header.vertexCount = vertices.size();
+        header.indexCount = indices.size();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(Vertex));
+        file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+    }
+
     void PaiModel::Builder::loadModel(const std::string &filepath)
     {
+        std::string cachePath = filepath + ".pmesh";
+        std::error_code ec;
+        if (std::filesystem::exists(cachePath, ec) &&
+            std::filesystem::last_write_time(cachePath, ec) >=
+                std::filesystem::last_write_time(filepath, ec))
+        {
+            if (loadMeshCache(cachePath))
+            {
+                return;
+            }
+        }
+
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
@@ -171,9 +243,21 @@ namespace pai
         vertices.clear();
         indices.clear();
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-        for (const auto &shape : shapes)
+        // deduplicate each shape on its own worker with a private map, then merge the
+        // (much smaller) unique sets sequentially; output order matches the old
+        // single-threaded loop because shapes are merged in order
+        struct ShapeResult
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices; // into the shape-local vertex array
+        };
+
+        auto dedupShape = [&attrib](const tinyobj::shape_t &shape)
         {
+            ShapeResult result{};
+            std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+            uniqueVertices.reserve(shape.mesh.indices.size());
+            result.indices.reserve(shape.mesh.indices.size());
             for (const auto &index : shape.mesh.indices)
             {
                 Vertex vertex{};
@@ -210,14 +294,50 @@ namespace pai
                     };
                 }
 
+                if (uniqueVertices.count(vertex) == 0)
+                {
+                    uniqueVertices[vertex] = static_cast<uint32_t>(result.vertices.size());
+                    result.vertices.push_back(vertex);
+                }
+                result.indices.push_back(uniqueVertices[vertex]);
+            }
+            return result;
+        };
+
+        std::vector<std::future<ShapeResult>> shapeFutures;
+        shapeFutures.reserve(shapes.size());
+        for (const auto &shape : shapes)
+        {
+            shapeFutures.push_back(std::async(std::launch::async, dedupShape, std::cref(shape)));
+        }
+
+        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        uniqueVertices.reserve(attrib.vertices.size() / 3);
+        vertices.reserve(attrib.vertices.size() / 3);
+
+        for (auto &shapeFuture : shapeFutures)
+        {
+            auto result = shapeFuture.get();
+            std::vector<uint32_t> remap(result.vertices.size());
+            for (size_t i = 0; i < result.vertices.size(); i++)
+            {
+                const auto &vertex = result.vertices[i];
                 if (uniqueVertices.count(vertex) == 0)
                 {
                     uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
                     vertices.push_back(vertex);
                 }
-                indices.push_back(uniqueVertices[vertex]);
+                remap[i] = uniqueVertices[vertex];
+            }
+
+            indices.reserve(indices.size() + result.indices.size());
+            for (uint32_t localIndex : result.indices)
+            {
+                indices.push_back(remap[localIndex]);
             }
         }
+
+        writeMeshCache(cachePath);
     }
 
 }
\ No newline at end of file
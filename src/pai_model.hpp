@@ -2,6 +2,7 @@
 
 #include "base/pai_buffer.hpp"
 #include "base/pai_device.hpp"
+#include "base/pai_transfer_batch.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -40,6 +41,10 @@ namespace pai
             std::vector<uint32_t> indices{};
 
             void loadModel(const std::string &filepath);
+
+        private:
+            bool loadMeshCache(const std::string &cachePath);
+            void writeMeshCache(const std::string &cachePath);
         };
 
         PaiModel(PaiDevice &device, const PaiModel::Builder &builder);
@@ -55,8 +60,8 @@ namespace pai
         void draw(VkCommandBuffer commandBuffer);
 
     private:
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        void createVertexBuffers(PaiTransferBatch &batch, const std::vector<Vertex> &vertices);
+        void createIndexBuffers(PaiTransferBatch &batch, const std::vector<uint32_t> &indices);
 
         PaiDevice &paiDevice;
 
@@ -1,11 +1,15 @@
 #include "pai_pixel.hpp"
 
+#include "base/pai_swap_chain.hpp"
+#include "base/pai_transfer_batch.hpp"
 #include "pai_utils.hpp"
+#include "pai_world_file.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
 // std
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstring>
@@ -39,6 +43,16 @@ namespace pai
         return bindingDescriptions;
     }
 
+    std::vector<VkVertexInputBindingDescription> PaiPixel::Vertex::getInstanceBindingDescriptions()
+    {
+        // same buffer layout, advanced once per instance instead of per vertex
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        return bindingDescriptions;
+    }
+
     std::vector<VkVertexInputAttributeDescription> PaiPixel::Vertex::getAttributeDescriptions()
     {
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
@@ -68,27 +82,171 @@ namespace pai
         }
         uint32_t count = static_cast<uint32_t>(vertices.size());
         createVertexBuffers(vertices);
+        createStagingRing();
         size = size * 0.90f;
     }
+
+    PaiPixel::PaiPixel(PaiDevice &device, const PaiWorldFile &worldFile)
+        : paiDevice{device},
+          vertices(worldFile.cellCount())
+    {
+        int height = worldFile.getHeight();
+        int width = worldFile.getWidth();
+        assert(height == width && "cell grid assumes square worlds");
+        paiWorld = std::make_unique<PaiWorld>(worldFile);
+        size = 2.f / height;
+        // one pass: position and wall state both come from the mapped bitmap;
+        // the file is in world order, transposed from the vertex layout (see
+        // addState)
+        for (int i = 0; i < height; i++)
+        {
+            for (int j = 0; j < width; j++)
+            {
+                Vertex &vertex = vertices[(i * height) + j];
+                vertex.position = {(i * size) - ((height / 2.f) * size), (j * size) - ((width / 2.f) * size), i, j};
+                if (worldFile.isWall(static_cast<size_t>(j) * height + i))
+                {
+                    vertex.state = glm::vec4{1};
+                }
+            }
+        }
+        createVertexBuffers(vertices);
+        createStagingRing();
+        size = size * 0.90f;
+    }
+
     void PaiPixel::addState(glm::vec2 state)
     {
-        vertices[(state.x * paiWorld->getHeight()) + state.y].state = glm::vec4{1};
-        vertexCount = static_cast<uint32_t>(vertices.size());
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
+        uint32_t cellIndex = (state.x * paiWorld->getHeight()) + state.y;
+        vertices[cellIndex].state = glm::vec4{1};
+        markDirty(cellIndex);
+        paiWorld->addState(glm::vec2(state.y, state.x));
+    }
+
+    void PaiPixel::addStateLocal(glm::vec2 state)
+    {
+        uint32_t cellIndex = (state.x * paiWorld->getHeight()) + state.y;
+        vertices[cellIndex].state = glm::vec4{1};
+        paiWorld->addState(glm::vec2(state.y, state.x));
+    }
+
+    void PaiPixel::markDirty(uint32_t cellIndex)
+    {
+        // every buffer version needs the cell; each list drains on its own frame
+        for (auto &dirty : pendingDirty)
+        {
+            dirty.push_back(cellIndex);
+        }
+    }
+
+    void PaiPixel::flushPending(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        auto &dirtyCells = pendingDirty[frameIndex];
+        if (dirtyCells.empty())
+        {
+            return;
+        }
+        std::sort(dirtyCells.begin(), dirtyCells.end());
+        dirtyCells.erase(std::unique(dirtyCells.begin(), dirtyCells.end()), dirtyCells.end());
+
+        if (directWrite)
+        {
+            // host-visible device-local memory: write the runs straight into the
+            // persistently mapped buffer; coherent host writes made before the
+            // frame's submit need no barrier
+            VkDeviceSize vertexSize = sizeof(vertices[0]);
+            size_t i = 0;
+            while (i < dirtyCells.size())
+            {
+                size_t runEnd = i + 1;
+                while (runEnd < dirtyCells.size() && dirtyCells[runEnd] == dirtyCells[runEnd - 1] + 1)
+                {
+                    runEnd++;
+                }
+                uint32_t first = dirtyCells[i];
+                vertexBuffers[frameIndex]->writeToBuffer(
+                    (void *)(vertices.data() + first), (runEnd - i) * vertexSize, first * vertexSize);
+                i = runEnd;
+            }
+            dirtyCells.clear();
+            return;
+        }
+
+        // compact runs of adjacent cells into this frame's staging region and one
+        // copy region each; the renderer already waited this frame's fence, so both
+        // the staging region and the buffer version are out of flight
+        VkDeviceSize vertexSize = sizeof(vertices[0]);
+        VkDeviceSize regionBase = frameIndex * stagingRing->getAlignmentSize();
+        VkDeviceSize cursor = 0;
+        std::vector<VkBufferCopy> regions;
+        size_t i = 0;
+        while (i < dirtyCells.size())
+        {
+            size_t runEnd = i + 1;
+            while (runEnd < dirtyCells.size() && dirtyCells[runEnd] == dirtyCells[runEnd - 1] + 1)
+            {
+                runEnd++;
+            }
+            uint32_t first = dirtyCells[i];
+            VkDeviceSize runBytes = (runEnd - i) * vertexSize;
+            stagingRing->writeToBuffer((void *)(vertices.data() + first), runBytes, regionBase + cursor);
+
+            VkBufferCopy region{};
+            region.srcOffset = regionBase + cursor;
+            region.dstOffset = first * vertexSize;
+            region.size = runBytes;
+            regions.push_back(region);
+
+            cursor += runBytes;
+            i = runEnd;
+        }
+        vkCmdCopyBuffer(
+            commandBuffer,
+            stagingRing->getBuffer(),
+            vertexBuffers[frameIndex]->getBuffer(),
+            static_cast<uint32_t>(regions.size()),
+            regions.data());
 
-        PaiBuffer stagingBuffer{
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = vertexBuffers[frameIndex]->getBuffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &barrier,
+            0,
+            nullptr);
+
+        dirtyCells.clear();
+    }
+
+    void PaiPixel::createStagingRing()
+    {
+        pendingDirty.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+        if (directWrite)
+        {
+            // direct writes land in the mapped vertex buffers; no staging needed
+            return;
+        }
+        stagingRing = std::make_unique<PaiBuffer>(
             paiDevice,
-            vertexSize,
-            vertexCount,
+            sizeof(vertices[0]) * vertices.size(),
+            PaiSwapChain::MAX_FRAMES_IN_FLIGHT,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-        paiDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
-        paiWorld->addState(glm::vec2(state.y, state.x));
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        stagingRing->map();
     }
 
     PaiPixel::~PaiPixel() {}
@@ -99,30 +257,59 @@ namespace pai
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
         uint32_t vertexSize = sizeof(vertices[0]);
 
-        PaiBuffer stagingBuffer{
-            paiDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
+        // prefer a host-visible device-local heap (ReBAR): the buffers stay
+        // persistently mapped and updates become plain memcpys with no staging
+        directWrite = paiDevice.hasMemoryType(
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        VkMemoryPropertyFlags memoryFlags =
+            directWrite ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                        : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-
-        vertexBuffer = std::make_unique<PaiBuffer>(
-            paiDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        vertexBuffers.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &vertexBuffer : vertexBuffers)
+        {
+            vertexBuffer = std::make_unique<PaiBuffer>(
+                paiDevice,
+                vertexSize,
+                vertexCount,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                memoryFlags);
+        }
+        if (directWrite)
+        {
+            for (auto &vertexBuffer : vertexBuffers)
+            {
+                vertexBuffer->map();
+                vertexBuffer->writeToBuffer((void *)vertices.data(), bufferSize);
+            }
+        }
+        else
+        {
+            PaiTransferBatch batch{paiDevice};
+            for (auto &vertexBuffer : vertexBuffers)
+            {
+                batch.upload(vertices.data(), bufferSize, vertexBuffer->getBuffer());
+            }
+            batch.submit();
+        }
+    }
 
-        paiDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+    std::vector<VkBuffer> PaiPixel::getStateBuffers()
+    {
+        std::vector<VkBuffer> buffers;
+        for (auto &vertexBuffer : vertexBuffers)
+        {
+            buffers.push_back(vertexBuffer->getBuffer());
+        }
+        return buffers;
     }
 
-    void PaiPixel::bind(VkCommandBuffer commandBuffer)
+    void PaiPixel::bind(VkCommandBuffer commandBuffer, int frameIndex)
     {
-        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+        VkBuffer buffers[] = {vertexBuffers[frameIndex]->getBuffer()};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
     }
@@ -133,4 +320,54 @@ namespace pai
         vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
     }
 
+    void PaiPixel::drawInstanced(VkCommandBuffer commandBuffer)
+    {
+        // one quad per cell, corners generated in the vertex shader
+        vkCmdDraw(commandBuffer, 4, vertexCount, 0, 0);
+    }
+
+    void PaiPixel::drawVisible(VkCommandBuffer commandBuffer, bool instanced)
+    {
+        // the shaders place cells directly in clip space, so the visible window is
+        // the [-1,1] box; cell (i, j) spans [origin + index * size, + size] per axis
+        int height = paiWorld->getHeight();
+        int width = paiWorld->getWidth();
+        float originX = -(height / 2.f) * size;
+        float originY = -(width / 2.f) * size;
+
+        auto visibleRange = [&](float origin, int count, int &first, int &last)
+        {
+            first = static_cast<int>(glm::floor((-1.f - origin) / size));
+            last = static_cast<int>(glm::ceil((1.f - origin) / size)) - 1;
+            if (last < 0 || first >= count)
+            {
+                return false;
+            }
+            first = glm::max(first, 0);
+            last = glm::min(last, count - 1);
+            return true;
+        };
+
+        int firstRow, lastRow, firstCell, lastCell;
+        if (!visibleRange(originX, height, firstRow, lastRow) ||
+            !visibleRange(originY, width, firstCell, lastCell))
+        {
+            return;
+        }
+
+        uint32_t cellsPerRow = static_cast<uint32_t>(lastCell - firstCell + 1);
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            uint32_t firstVertex = static_cast<uint32_t>(row * height + firstCell);
+            if (instanced)
+            {
+                vkCmdDraw(commandBuffer, 4, cellsPerRow, 0, firstVertex);
+            }
+            else
+            {
+                vkCmdDraw(commandBuffer, cellsPerRow, 1, firstVertex, 0);
+            }
+        }
+    }
+
 }
\ No newline at end of file
@@ -16,6 +16,8 @@
 
 namespace pai
 {
+    class PaiWorldFile;
+
     class PaiPixel
     {
     public:
@@ -24,35 +26,78 @@ namespace pai
             glm::vec4 position{};
             glm::vec4 state{};
             static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputBindingDescription> getInstanceBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 
         };
 
         PaiPixel(PaiDevice &device, const int height, const int width, std::vector<glm::vec2> walls);
+        // Builds the grid from a mapped world file: vertex states come straight
+        // from the packed bitmap in one pass instead of per-wall scatter writes
+        PaiPixel(PaiDevice &device, const PaiWorldFile &worldFile);
         ~PaiPixel();
 
         PaiPixel(const PaiPixel &) = delete;
         PaiPixel &operator=(const PaiPixel &) = delete;
 
         void draw(VkCommandBuffer commandBuffer);
-        void bind(VkCommandBuffer commandBuffer);
+        void drawInstanced(VkCommandBuffer commandBuffer);
+        // Draws only the cell rows intersecting the visible clip-space box; rows are
+        // contiguous in the vertex buffer so each one is a first-vertex/count range.
+        void drawVisible(VkCommandBuffer commandBuffer, bool instanced);
+        void bind(VkCommandBuffer commandBuffer, int frameIndex);
 
         float getSize(){ return size; };
         glm::vec4 getColor(){ return color; };
         glm::vec4 getActions(glm::vec2 state){ return paiWorld->actions(state); };
+        void getActions(const std::vector<glm::ivec2> &states, std::vector<glm::vec4> &out)
+        {
+            paiWorld->actions(states, out);
+        }
+        void getActionsMask(const std::vector<glm::ivec2> &states, std::vector<uint8_t> &out)
+        {
+            paiWorld->actionsMask(states, out);
+        }
         void addState(glm::vec2 state);
+        // Updates the CPU mirror and the world only; use when GridComputeSystem
+        // applies the visual update on the GPU instead of the staging-ring upload.
+        void addStateLocal(glm::vec2 state);
+        // Records the copies for this frame's pending cells into the frame command
+        // buffer, outside the render pass. Each frame in flight owns its own vertex
+        // buffer version, so the copy never touches a buffer another frame reads.
+        void flushPending(VkCommandBuffer commandBuffer, int frameIndex);
+
+        VkBuffer getStateBuffer(int frameIndex) { return vertexBuffers[frameIndex]->getBuffer(); }
+        std::vector<VkBuffer> getStateBuffers();
+        uint32_t getCellCount() { return vertexCount; }
+        VkDeviceSize getStateBufferSize() { return sizeof(Vertex) * vertexCount; }
+        int getGridHeight() { return paiWorld->getHeight(); }
 
     private:
         void createVertexBuffers(const std::vector<Vertex> &vertices);
-        
+        void createStagingRing();
+        void markDirty(uint32_t cellIndex);
 
         PaiDevice &paiDevice;
         std::unique_ptr<PaiWorld> paiWorld;
 
-        std::unique_ptr<PaiBuffer> vertexBuffer;
+        // one vertex buffer version per frame in flight; bind selects by frame index
+        std::vector<std::unique_ptr<PaiBuffer>> vertexBuffers;
         uint32_t vertexCount;
         std::vector<Vertex> vertices;
 
+        // true when the versions live in host-visible device-local memory (ReBAR)
+        // and stay persistently mapped, so flushes are plain memcpys
+        bool directWrite = false;
+
+        // persistently mapped staging ring, one region per frame in flight;
+        // unused on the direct-write path
+        std::unique_ptr<PaiBuffer> stagingRing;
+
+        // cells touched since each buffer version's last flush, compacted into
+        // copy regions when that frame comes around again
+        std::vector<std::vector<uint32_t>> pendingDirty;
+
         float size;
         glm::vec4 color = {.9f, .9f, .9f, .5f};
     };
@@ -0,0 +1,106 @@
+#include "pai_trajectory_recorder.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+// libs
+#include <unistd.h>
+
+namespace pai
+{
+
+    namespace
+    {
+        constexpr char MAGIC[4] = {'P', 'T', 'R', 'J'};
+        constexpr uint32_t VERSION = 1;
+    }
+
+    PaiTrajectoryRecorder::PaiTrajectoryRecorder(const std::string &filepath, size_t capacity)
+        : ring(capacity)
+    {
+        file = std::fopen(filepath.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("failed to open trajectory log: " + filepath);
+        }
+
+        uint32_t recordSize = sizeof(Record);
+        std::fwrite(MAGIC, sizeof(MAGIC), 1, file);
+        std::fwrite(&VERSION, sizeof(VERSION), 1, file);
+        std::fwrite(&recordSize, sizeof(recordSize), 1, file);
+
+        drainThread = std::thread([this]() { drainLoop(); });
+    }
+
+    PaiTrajectoryRecorder::~PaiTrajectoryRecorder()
+    {
+        running.store(false, std::memory_order_release);
+        drainThread.join();
+        // drainLoop wrote and synced everything still in the ring before exiting
+        std::fclose(file);
+    }
+
+    void PaiTrajectoryRecorder::record(const Record &record)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= ring.size())
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring[h % ring.size()] = record;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    size_t PaiTrajectoryRecorder::drain()
+    {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        size_t count = static_cast<size_t>(h - t);
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        // the occupied span wraps at most once, so at most two contiguous writes
+        size_t first = static_cast<size_t>(t % ring.size());
+        size_t firstCount = std::min(count, ring.size() - first);
+        std::fwrite(ring.data() + first, sizeof(Record), firstCount, file);
+        if (firstCount < count)
+        {
+            std::fwrite(ring.data(), sizeof(Record), count - firstCount, file);
+        }
+        tail.store(h, std::memory_order_release);
+        return count;
+    }
+
+    void PaiTrajectoryRecorder::drainLoop()
+    {
+        using clock = std::chrono::steady_clock;
+        constexpr auto syncInterval = std::chrono::milliseconds(250);
+        auto lastSync = clock::now();
+        size_t unsynced = 0;
+
+        while (running.load(std::memory_order_acquire))
+        {
+            unsynced += drain();
+            auto now = clock::now();
+            if (unsynced > 0 && now - lastSync >= syncInterval)
+            {
+                std::fflush(file);
+                fsync(fileno(file));
+                lastSync = now;
+                unsynced = 0;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        drain();
+        std::fflush(file);
+        fsync(fileno(file));
+    }
+
+}
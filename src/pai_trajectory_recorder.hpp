@@ -0,0 +1,58 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pai
+{
+    // Records agent trajectories for offline training without stalling the run
+    // loop: the hot path appends fixed-size records into a preallocated ring with
+    // a single atomic cursor pair (no allocation, no lock, no I/O), and a
+    // background thread drains the ring into a compact binary log with periodic
+    // fsync. Single producer, single consumer.
+    class PaiTrajectoryRecorder
+    {
+    public:
+        struct Record
+        {
+            uint32_t frameIndex;
+            float frameTime;
+            glm::vec2 state;
+            glm::vec4 actions;
+        };
+
+        PaiTrajectoryRecorder(const std::string &filepath, size_t capacity = 1 << 16);
+        ~PaiTrajectoryRecorder();
+
+        PaiTrajectoryRecorder(const PaiTrajectoryRecorder &) = delete;
+        PaiTrajectoryRecorder &operator=(const PaiTrajectoryRecorder &) = delete;
+
+        // hot path; drops the record (counted) when the drain thread is behind
+        void record(const Record &record);
+
+        uint64_t droppedRecords() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        void drainLoop();
+        size_t drain();
+
+        std::vector<Record> ring;
+        std::atomic<uint64_t> head{0}; // next slot the producer writes
+        std::atomic<uint64_t> tail{0}; // next slot the consumer reads
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> running{true};
+
+        std::FILE *file = nullptr;
+        std::thread drainThread;
+    };
+}
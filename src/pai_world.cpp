@@ -1,11 +1,27 @@
 #include "pai_world.hpp"
+#include "pai_world_file.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
 
 namespace pai
 {
     PaiWorld::PaiWorld(int height, int width) : worldHeight{height},
                                                 worldWidth{width}
     {
-        worldState = std::vector<std::vector<int>>(worldWidth, std::vector<int>(worldHeight, 1));
+        worldState = std::vector<uint8_t>(static_cast<size_t>(worldWidth) * worldHeight, 1);
+    }
+
+    PaiWorld::PaiWorld(const PaiWorldFile &file) : worldHeight{file.getHeight()},
+                                                   worldWidth{file.getWidth()}
+    {
+        // one pass over the packed bits: 1 = free, 0 = wall, same as addStates
+        worldState.resize(file.cellCount());
+        for (size_t i = 0; i < worldState.size(); i++)
+        {
+            worldState[i] = file.isWall(i) ? 0 : 1;
+        }
     }
 
     PaiWorld::~PaiWorld() {}
@@ -17,24 +33,81 @@ namespace pai
         int top = state.y <= 0 ? 0 : state.y - 1;
         int bottom = state.y >= worldHeight - 1 ? worldHeight - 1 : state.y + 1;
         return {
-            left == state.x ? 0 : worldState[int(state.y)][left],
-            right == state.x ? 0 : worldState[int(state.y)][right],
-            top == state.y ? 0 : worldState[top][int(state.x)],
-            bottom == state.y ? 0 : worldState[bottom][int(state.x)]};
+            left == state.x ? 0 : worldState[cellIndex(int(state.y), left)],
+            right == state.x ? 0 : worldState[cellIndex(int(state.y), right)],
+            top == state.y ? 0 : worldState[cellIndex(top, int(state.x))],
+            bottom == state.y ? 0 : worldState[cellIndex(bottom, int(state.x))]};
+    }
+
+    void PaiWorld::actions(const std::vector<glm::ivec2> &states, std::vector<glm::vec4> &out)
+    {
+        out.resize(states.size());
+        const uint8_t *cells = worldState.data();
+        for (size_t i = 0; i < states.size(); i++)
+        {
+            int x = states[i].x;
+            int y = states[i].y;
+            int left = x <= 0 ? 0 : x - 1;
+            int right = x >= worldWidth - 1 ? worldWidth - 1 : x + 1;
+            int top = y <= 0 ? 0 : y - 1;
+            int bottom = y >= worldHeight - 1 ? worldHeight - 1 : y + 1;
+            out[i] = {
+                left == x ? 0.f : float(cells[cellIndex(y, left)]),
+                right == x ? 0.f : float(cells[cellIndex(y, right)]),
+                top == y ? 0.f : float(cells[cellIndex(top, x)]),
+                bottom == y ? 0.f : float(cells[cellIndex(bottom, x)])};
+        }
+    }
+
+    void PaiWorld::actionsMask(const std::vector<glm::ivec2> &states, std::vector<uint8_t> &out)
+    {
+        out.resize(states.size());
+        const uint8_t *cells = worldState.data();
+        for (size_t i = 0; i < states.size(); i++)
+        {
+            int x = states[i].x;
+            int y = states[i].y;
+            int left = x <= 0 ? 0 : x - 1;
+            int right = x >= worldWidth - 1 ? worldWidth - 1 : x + 1;
+            int top = y <= 0 ? 0 : y - 1;
+            int bottom = y >= worldHeight - 1 ? worldHeight - 1 : y + 1;
+            uint8_t mask = 0;
+            mask |= (left != x && cells[cellIndex(y, left)] != 0) ? 1 : 0;
+            mask |= (right != x && cells[cellIndex(y, right)] != 0) ? 2 : 0;
+            mask |= (top != y && cells[cellIndex(top, x)] != 0) ? 4 : 0;
+            mask |= (bottom != y && cells[cellIndex(bottom, x)] != 0) ? 8 : 0;
+            out[i] = mask;
+        }
     }
 
     void PaiWorld::addStates(std::vector<glm::vec2> states, int stateValue)
     {
+        // sort the cells so runs of adjacent ones become a single contiguous write
+        std::vector<size_t> cells;
+        cells.reserve(states.size());
         for (auto &state : states)
         {
-            addState(state, stateValue);
+            cells.push_back(cellIndex(state.x, state.y));
+        }
+        std::sort(cells.begin(), cells.end());
+
+        size_t i = 0;
+        while (i < cells.size())
+        {
+            size_t runEnd = i + 1;
+            while (runEnd < cells.size() && cells[runEnd] == cells[runEnd - 1] + 1)
+            {
+                runEnd++;
+            }
+            std::memset(worldState.data() + cells[i], stateValue, runEnd - i);
+            i = runEnd;
         }
     }
 
     void PaiWorld::addState(glm::vec2 state, int stateValue)
     {
 
-        worldState[state.x][state.y] = stateValue;
+        worldState[cellIndex(state.x, state.y)] = stateValue;
     }
 
-}
\ No newline at end of file
+}
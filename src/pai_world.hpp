@@ -1,22 +1,35 @@
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 
 namespace pai
 {
+    class PaiWorldFile;
+
     class PaiWorld
     {
     private:
         int worldHeight;
         int worldWidth;
-        std::vector<std::vector<int>> worldState;
+        // one contiguous byte per cell, row-major, so neighbor lookups stay in cache
+        std::vector<uint8_t> worldState;
+
+        size_t cellIndex(int a, int b) const { return static_cast<size_t>(a) * worldHeight + b; }
     public:
         PaiWorld(int height, int width);
+        // Expands a mapped world file's packed bitmap straight into the flat state
+        PaiWorld(const PaiWorldFile &file);
         ~PaiWorld();
 
         glm::vec4 actions(glm::vec2 state);
+        // Batched queries for many agents in one pass over the flat cell array. The
+        // mask variant packs left/right/top/bottom into bits 0..3 of one byte per agent.
+        void actions(const std::vector<glm::ivec2> &states, std::vector<glm::vec4> &out);
+        void actionsMask(const std::vector<glm::ivec2> &states, std::vector<uint8_t> &out);
         void addStates(std::vector<glm::vec2> states, int stateValue = 0);
         void addState(glm::vec2 state, int stateValue = 0);
         int getHeight(){ return worldHeight; };
+        int getWidth(){ return worldWidth; };
     };
 
 } // namespace pai
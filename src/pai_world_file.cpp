@@ -0,0 +1,55 @@
+#include "pai_world_file.hpp"
+
+// std
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace pai
+{
+
+    PaiWorldFile::PaiWorldFile(const std::string &filepath) : file{filepath}
+    {
+        if (file.size() < sizeof(Header))
+        {
+            throw std::runtime_error("world file too small: " + filepath);
+        }
+        header = reinterpret_cast<const Header *>(file.data());
+        if (std::memcmp(header->magic, "PWLD", 4) != 0 || header->version != VERSION)
+        {
+            throw std::runtime_error("not a world file: " + filepath);
+        }
+        if (file.size() < sizeof(Header) + (cellCount() + 7) / 8)
+        {
+            throw std::runtime_error("world file truncated: " + filepath);
+        }
+        bits = reinterpret_cast<const uint8_t *>(file.data() + sizeof(Header));
+    }
+
+    void PaiWorldFile::write(
+        const std::string &filepath, int height, int width, const std::vector<glm::vec2> &walls)
+    {
+        Header header{};
+        std::memcpy(header.magic, "PWLD", 4);
+        header.version = VERSION;
+        header.height = static_cast<uint32_t>(height);
+        header.width = static_cast<uint32_t>(width);
+
+        size_t cells = static_cast<size_t>(height) * width;
+        std::vector<uint8_t> bitmap((cells + 7) / 8, 0);
+        for (const auto &wall : walls)
+        {
+            size_t cell = static_cast<size_t>(wall.x) * height + static_cast<size_t>(wall.y);
+            bitmap[cell >> 3] |= 1 << (cell & 7);
+        }
+
+        std::ofstream out{filepath, std::ios::binary | std::ios::trunc};
+        if (!out.is_open())
+        {
+            throw std::runtime_error("failed to open world file for writing: " + filepath);
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(bitmap.data()), bitmap.size());
+    }
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "base/pai_mapped_file.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pai
+{
+    // Binary world format for large wall layouts: a small header with the grid
+    // dimensions followed by a packed cell bitmap, one bit per cell in the flat
+    // row-major order of PaiWorld's state array, set = wall. A 4096x4096 world is
+    // a 2 MiB file; the mapping reads straight from the page cache, so loading is
+    // one pass over the bits instead of a hardcoded per-wall scatter.
+    class PaiWorldFile
+    {
+    public:
+        struct Header
+        {
+            char magic[4];    // "PWLD"
+            uint32_t version; // bumped on layout changes
+            uint32_t height;
+            uint32_t width;
+        };
+
+        static constexpr uint32_t VERSION = 1;
+
+        // Maps and validates; throws std::runtime_error on a missing or malformed file
+        PaiWorldFile(const std::string &filepath);
+
+        PaiWorldFile(const PaiWorldFile &) = delete;
+        PaiWorldFile &operator=(const PaiWorldFile &) = delete;
+
+        int getHeight() const { return static_cast<int>(header->height); }
+        int getWidth() const { return static_cast<int>(header->width); }
+        size_t cellCount() const { return static_cast<size_t>(header->height) * header->width; }
+        bool isWall(size_t cellIndex) const
+        {
+            return (bits[cellIndex >> 3] >> (cellIndex & 7)) & 1;
+        }
+
+        // Writer for level-generation pipelines; walls use the same (x, y) cell
+        // convention as PaiWorld::addStates
+        static void write(
+            const std::string &filepath, int height, int width, const std::vector<glm::vec2> &walls);
+
+    private:
+        PaiMappedFile file;
+        const Header *header;
+        const uint8_t *bits;
+    };
+}
@@ -0,0 +1,241 @@
+#include "grid_compute_system.hpp"
+
+#include "../base/pai_mapped_file.hpp"
+#include "../base/pai_swap_chain.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
+
+namespace pai
+{
+
+    struct GridComputePush
+    {
+        int32_t commandCount;
+        int32_t gridHeight;
+    };
+
+    GridComputeSystem::GridComputeSystem(
+        PaiDevice &device,
+        std::vector<VkBuffer> cellBuffers,
+        VkDeviceSize cellBufferSize,
+        int gridHeight)
+        : paiDevice{device},
+          gridHeight{gridHeight},
+          cellBuffers{std::move(cellBuffers)},
+          cellBufferSize{cellBufferSize}
+    {
+        assert(
+            this->cellBuffers.size() == PaiSwapChain::MAX_FRAMES_IN_FLIGHT &&
+            "expected one cell buffer per frame in flight");
+        pendingCommands.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+        createDescriptors(cellBufferSize);
+        createPipelineLayout();
+        createPipeline();
+    }
+
+    GridComputeSystem::~GridComputeSystem()
+    {
+        vkDestroyPipeline(paiDevice.device(), computePipeline, nullptr);
+        vkDestroyPipelineLayout(paiDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void GridComputeSystem::createDescriptors(VkDeviceSize cellBufferSize)
+    {
+        descriptorPool =
+            PaiDescriptorPool::Builder(paiDevice)
+                .setMaxSets(PaiSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(
+                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, PaiSwapChain::MAX_FRAMES_IN_FLIGHT * 2)
+                .build();
+
+        setLayout =
+            PaiDescriptorSetLayout::Builder(paiDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .build();
+
+        commandBuffers.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+        descriptorSets.resize(PaiSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (int i = 0; i < PaiSwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            commandBuffers[i] = std::make_unique<PaiBuffer>(
+                paiDevice,
+                sizeof(GridUpdateCommand) * MAX_COMMANDS,
+                1,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            commandBuffers[i]->map();
+
+            VkDescriptorBufferInfo cellInfo{cellBuffers[i], 0, cellBufferSize};
+            auto commandInfo = commandBuffers[i]->descriptorInfo();
+            PaiDescriptorWriter(*setLayout, *descriptorPool)
+                .writeBuffer(0, &cellInfo)
+                .writeBuffer(1, &commandInfo)
+                .build(descriptorSets[i]);
+        }
+    }
+
+    void GridComputeSystem::createPipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(GridComputePush);
+
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{setLayout->getDescriptorSetLayout()};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(paiDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void GridComputeSystem::createPipeline()
+    {
+        PaiMappedFile computeCode{ENGINE_DIR "shaders/pixel_update.comp.spv"};
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = computeCode.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t *>(computeCode.data());
+
+        VkShaderModule computeShaderModule;
+        if (vkCreateShaderModule(paiDevice.device(), &moduleInfo, nullptr, &computeShaderModule) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shader module");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = computeShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        if (vkCreateComputePipelines(
+                paiDevice.device(),
+                paiDevice.pipelineCache(),
+                1,
+                &pipelineInfo,
+                nullptr,
+                &computePipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute pipeline!");
+        }
+
+        vkDestroyShaderModule(paiDevice.device(), computeShaderModule, nullptr);
+    }
+
+    void GridComputeSystem::queueUpdate(glm::ivec2 cell, int value)
+    {
+        // every buffer version gets the command; each list drains on its own frame
+        for (auto &pending : pendingCommands)
+        {
+            assert(pending.size() < MAX_COMMANDS && "grid update command list overflow");
+            pending.push_back({cell, value});
+        }
+    }
+
+    void GridComputeSystem::dispatch(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        auto &pending = pendingCommands[frameIndex];
+        if (pending.empty())
+        {
+            return;
+        }
+
+        uint32_t commandCount = static_cast<uint32_t>(pending.size());
+        commandBuffers[frameIndex]->writeToBuffer(
+            pending.data(), commandCount * sizeof(GridUpdateCommand));
+
+        // order after any flushPending copies and the last draws that touched this
+        // buffer version; barriers order against all earlier submissions on the queue
+        VkBufferMemoryBarrier preBarrier{};
+        preBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        preBarrier.srcAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        preBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        preBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        preBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        preBarrier.buffer = cellBuffers[frameIndex];
+        preBarrier.offset = 0;
+        preBarrier.size = cellBufferSize;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &preBarrier,
+            0,
+            nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0,
+            1,
+            &descriptorSets[frameIndex],
+            0,
+            nullptr);
+
+        GridComputePush push{};
+        push.commandCount = static_cast<int32_t>(commandCount);
+        push.gridHeight = gridHeight;
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(GridComputePush),
+            &push);
+
+        vkCmdDispatch(commandBuffer, (commandCount + 63) / 64, 1, 1);
+
+        // the vertex input stage of this frame's draws must see the compute writes
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = cellBuffers[frameIndex];
+        barrier.offset = 0;
+        barrier.size = cellBufferSize;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &barrier,
+            0,
+            nullptr);
+
+        pending.clear();
+    }
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../base/pai_buffer.hpp"
+#include "../base/pai_descriptors.hpp"
+#include "../base/pai_device.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace pai
+{
+    // Applies queued cell updates to the grid's state buffers on the GPU, so large
+    // worlds skip the per-step vertex re-upload. Queue updates while stepping the
+    // simulation, then record dispatch() on the frame command buffer before the
+    // render pass begins. The grid keeps one buffer version per frame in flight, so
+    // each queued command is replayed once against every version as its frame comes
+    // around.
+    class GridComputeSystem
+    {
+    public:
+        static constexpr uint32_t MAX_COMMANDS = 1024; // per frame in flight
+
+        struct GridUpdateCommand
+        {
+            glm::ivec2 cell;
+            int32_t value;
+            int32_t pad{0};
+        };
+
+        GridComputeSystem(
+            PaiDevice &device,
+            std::vector<VkBuffer> cellBuffers,
+            VkDeviceSize cellBufferSize,
+            int gridHeight);
+        ~GridComputeSystem();
+
+        GridComputeSystem(const GridComputeSystem &) = delete;
+        GridComputeSystem &operator=(const GridComputeSystem &) = delete;
+
+        void queueUpdate(glm::ivec2 cell, int value);
+        void dispatch(VkCommandBuffer commandBuffer, int frameIndex);
+
+    private:
+        void createDescriptors(VkDeviceSize cellBufferSize);
+        void createPipelineLayout();
+        void createPipeline();
+
+        PaiDevice &paiDevice;
+        int gridHeight;
+        std::vector<VkBuffer> cellBuffers; // one per frame in flight
+        VkDeviceSize cellBufferSize;
+
+        // one queue per buffer version; queueUpdate fans out, dispatch drains its own
+        std::vector<std::vector<GridUpdateCommand>> pendingCommands;
+        std::vector<std::unique_ptr<PaiBuffer>> commandBuffers;
+
+        std::unique_ptr<PaiDescriptorPool> descriptorPool;
+        std::unique_ptr<PaiDescriptorSetLayout> setLayout;
+        std::vector<VkDescriptorSet> descriptorSets;
+
+        VkPipelineLayout pipelineLayout;
+        VkPipeline computePipeline;
+    };
+}
@@ -1,5 +1,7 @@
 #include "pixel_system.hpp"
 
+#include "../base/pai_renderer.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -20,17 +22,28 @@ namespace pai
         float size;
     };
 
+    struct PixelDrawData
+    {
+        glm::vec4 color{};
+        glm::vec4 size{}; // x is the cell size, rest is std430 padding
+    };
+
     PixelSystem::PixelSystem(
-        PaiDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-        : paiDevice{device}
+        PaiDevice &device,
+        VkRenderPass renderPass,
+        VkDescriptorSetLayout globalSetLayout,
+        bool useGeometryShader)
+        : paiDevice{device}, renderPass{renderPass}, useGeometryShader{useGeometryShader}
     {
         createPipelineLayout(globalSetLayout);
         createPipeline(renderPass);
+        createBatchPipeline(renderPass, globalSetLayout);
     }
 
     PixelSystem::~PixelSystem()
     {
         vkDestroyPipelineLayout(paiDevice.device(), pipelineLayout, nullptr);
+        vkDestroyPipelineLayout(paiDevice.device(), batchPipelineLayout, nullptr);
     }
 
     void PixelSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
@@ -59,24 +72,296 @@ namespace pai
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-        PipelineConfigInfo pipelineConfig{};
-        PaiPipeline::pixelPipelineConfigInfo(pipelineConfig);
-        PaiPipeline::enableAlphaBlending(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
+        // the instanced path binds only the specialization variants from
+        // pipelineVariantFor, which carry their own reload watchers; a base
+        // pipeline here would never be bound
+        if (!useGeometryShader)
+        {
+            return;
+        }
+
+        auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+        PaiPipeline::pixelPipelineConfigInfo(*pipelineConfig);
+        PaiPipeline::enableAlphaBlending(*pipelineConfig);
+        pipelineConfig->renderPass = renderPass;
+        pipelineConfig->pipelineLayout = pipelineLayout;
         paiPipeline = std::make_unique<PaiPipeline>(
             paiDevice,
             "shaders/pixel.vert.spv",
             "shaders/pixel.geom.spv",
             "shaders/pixel.frag.spv",
-            pipelineConfig);
+            std::move(pipelineConfig));
+        // shader edits swap in without a restart or a dropped frame
+        paiPipeline->watchForReload();
+    }
+
+    void PixelSystem::createBatchPipeline(
+        VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
+    {
+        batchDescriptorPool =
+            PaiDescriptorPool::Builder(paiDevice)
+                .setMaxSets(1)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1)
+                .build();
+
+        batchSetLayout =
+            PaiDescriptorSetLayout::Builder(paiDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+                .build();
+
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+            globalSetLayout, batchSetLayout->getDescriptorSetLayout()};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        if (vkCreatePipelineLayout(
+                paiDevice.device(), &pipelineLayoutInfo, nullptr, &batchPipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+        PaiPipeline::pixelInstancedPipelineConfigInfo(*pipelineConfig);
+        PaiPipeline::enableAlphaBlending(*pipelineConfig);
+        pipelineConfig->renderPass = renderPass;
+        pipelineConfig->pipelineLayout = batchPipelineLayout;
+        batchPipeline = std::make_unique<PaiPipeline>(
+            paiDevice,
+            "shaders/pixel_batch.vert.spv",
+            "shaders/pixel.frag.spv",
+            std::move(pipelineConfig));
+        batchPipeline->watchForReload();
+    }
+
+    PaiPipeline &PixelSystem::pipelineVariantFor(PaiPixel *pixel)
+    {
+        float cellSize = pixel->getSize();
+        std::string key{reinterpret_cast<const char *>(&cellSize), sizeof(cellSize)};
+        auto variant = pipelineVariants.find(key);
+        if (variant == pipelineVariants.end())
+        {
+            auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+            PaiPipeline::pixelInstancedPipelineConfigInfo(*pipelineConfig);
+            PaiPipeline::enableAlphaBlending(*pipelineConfig);
+            pipelineConfig->renderPass = renderPass;
+            pipelineConfig->pipelineLayout = pipelineLayout;
+            PaiPipeline::addSpecializationConstant(
+                *pipelineConfig, 0, &cellSize, sizeof(cellSize));
+            variant = pipelineVariants
+                          .emplace(
+                              key,
+                              std::make_unique<PaiPipeline>(
+                                  paiDevice,
+                                  "shaders/pixel_instanced.vert.spv",
+                                  "shaders/pixel.frag.spv",
+                                  std::move(pipelineConfig)))
+                          .first;
+            // the variant owns its config, so rebuilds keep the baked cell size
+            variant->second->watchForReload();
+        }
+        return *variant->second;
+    }
+
+    void PixelSystem::rebuildBatch(FrameInfo &frameInfo)
+    {
+        auto &renderables = frameInfo.registry.pixelRenderables();
+        bool dirty = renderables.size() != batchEntries.size();
+        for (size_t i = 0; !dirty && i < renderables.size(); i++)
+        {
+            dirty = renderables[i].pixel != batchEntries[i].pixel;
+        }
+        if (!dirty)
+        {
+            return;
+        }
+
+        vkDeviceWaitIdle(paiDevice.device()); // old batch buffers may be in flight
+
+        batchEntries.clear();
+        VkDeviceSize totalSize = 0;
+        for (auto &renderable : renderables)
+        {
+            VkDeviceSize size = renderable.pixel->getStateBufferSize();
+            batchEntries.push_back({renderable.pixel, size, totalSize});
+            totalSize += size;
+        }
+        if (batchEntries.empty())
+        {
+            batchVertexBuffer = nullptr;
+            return;
+        }
+
+        batchVertexBuffer = std::make_unique<PaiBuffer>(
+            paiDevice,
+            totalSize,
+            1,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        drawDataBuffer = std::make_unique<PaiBuffer>(
+            paiDevice,
+            sizeof(PixelDrawData) * batchEntries.size(),
+            1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        drawDataBuffer->map();
+
+        indirectBuffer = std::make_unique<PaiBuffer>(
+            paiDevice,
+            sizeof(VkDrawIndirectCommand) * batchEntries.size(),
+            1,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        indirectBuffer->map();
+
+        std::vector<PixelDrawData> drawData(batchEntries.size());
+        std::vector<VkDrawIndirectCommand> commands(batchEntries.size());
+        for (size_t i = 0; i < batchEntries.size(); i++)
+        {
+            auto &entry = batchEntries[i];
+            drawData[i].color = entry.pixel->getColor();
+            drawData[i].size.x = entry.pixel->getSize();
+            // firstInstance offsets the per-instance attribute fetch into this
+            // grid's slice of the shared buffer
+            commands[i].vertexCount = 4;
+            commands[i].instanceCount = entry.pixel->getCellCount();
+            commands[i].firstVertex = 0;
+            commands[i].firstInstance =
+                static_cast<uint32_t>(entry.offset / sizeof(PaiPixel::Vertex));
+        }
+        drawDataBuffer->writeToBuffer(drawData.data());
+        indirectBuffer->writeToBuffer(commands.data());
+
+        auto bufferInfo = drawDataBuffer->descriptorInfo();
+        PaiDescriptorWriter(*batchSetLayout, *batchDescriptorPool)
+            .writeBuffer(0, &bufferInfo)
+            .build(batchDescriptorSet);
+    }
+
+    void PixelSystem::updateBatch(FrameInfo &frameInfo)
+    {
+        rebuildBatch(frameInfo);
+        if (batchEntries.empty())
+        {
+            return;
+        }
+
+        // make compute writes and the staging-ring copies to the per-grid
+        // buffers visible to the copies; flushPending's own barrier only
+        // chains its transfer writes to vertex input, not to transfer reads
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+
+        for (auto &entry : batchEntries)
+        {
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = 0;
+            copyRegion.dstOffset = entry.offset;
+            copyRegion.size = entry.size;
+            vkCmdCopyBuffer(
+                frameInfo.commandBuffer,
+                entry.pixel->getStateBuffer(frameInfo.frameIndex),
+                batchVertexBuffer->getBuffer(),
+                1,
+                &copyRegion);
+        }
+
+        VkBufferMemoryBarrier vertexBarrier{};
+        vertexBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        vertexBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vertexBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vertexBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vertexBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vertexBarrier.buffer = batchVertexBuffer->getBuffer();
+        vertexBarrier.offset = 0;
+        vertexBarrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &vertexBarrier,
+            0,
+            nullptr);
+    }
+
+    void PixelSystem::renderBatched(FrameInfo &frameInfo)
+    {
+        if (batchEntries.empty())
+        {
+            return;
+        }
+        uint32_t gpuScope = 0;
+        if (frameInfo.renderer != nullptr)
+        {
+            gpuScope = frameInfo.renderer->beginGpuScope(frameInfo.commandBuffer, "pixel");
+        }
+        batchPipeline->bind(frameInfo.commandBuffer);
+
+        std::array<VkDescriptorSet, 2> descriptorSets{
+            frameInfo.globalDescriptorSet, batchDescriptorSet};
+        uint32_t dynamicOffsets[] = {frameInfo.globalUboOffset, frameInfo.agentGridOffset};
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            batchPipelineLayout,
+            0,
+            static_cast<uint32_t>(descriptorSets.size()),
+            descriptorSets.data(),
+            2,
+            dynamicOffsets);
+
+        VkBuffer buffers[] = {batchVertexBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, buffers, offsets);
+
+        // one call covers every grid; needs the multiDrawIndirect device feature
+        vkCmdDrawIndirect(
+            frameInfo.commandBuffer,
+            indirectBuffer->getBuffer(),
+            0,
+            static_cast<uint32_t>(batchEntries.size()),
+            sizeof(VkDrawIndirectCommand));
+
+        if (frameInfo.renderer != nullptr)
+        {
+            frameInfo.renderer->endGpuScope(frameInfo.commandBuffer, gpuScope);
+        }
     }
 
     void PixelSystem::render(
         FrameInfo &frameInfo)
     {
-        paiPipeline->bind(frameInfo.commandBuffer);
+        uint32_t gpuScope = 0;
+        if (frameInfo.renderer != nullptr)
+        {
+            gpuScope = frameInfo.renderer->beginGpuScope(frameInfo.commandBuffer, "pixel");
+        }
+        if (useGeometryShader)
+        {
+            paiPipeline->bind(frameInfo.commandBuffer);
+        }
 
+        uint32_t dynamicOffsets[] = {frameInfo.globalUboOffset, frameInfo.agentGridOffset};
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -84,17 +369,19 @@ namespace pai
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            2,
+            dynamicOffsets);
 
-        for (auto &kv : frameInfo.gameObjects)
+        for (auto &renderable : frameInfo.registry.pixelRenderables())
         {
-            auto &obj = kv.second;
-            if (obj.pixel == nullptr)
-                continue;
+            if (!useGeometryShader)
+            {
+                pipelineVariantFor(renderable.pixel).bind(frameInfo.commandBuffer);
+            }
+
             PixelPush push{};
-            push.color = obj.pixel->getColor();
-            push.size = obj.pixel->getSize();
+            push.color = renderable.pixel->getColor();
+            push.size = renderable.pixel->getSize();
 
             vkCmdPushConstants(
                 frameInfo.commandBuffer,
@@ -104,8 +391,12 @@ namespace pai
                 sizeof(PixelPush),
                 &push);
 
-            obj.pixel->bind(frameInfo.commandBuffer);
-            obj.pixel->draw(frameInfo.commandBuffer);
+            renderable.pixel->bind(frameInfo.commandBuffer, frameInfo.frameIndex);
+            renderable.pixel->drawVisible(frameInfo.commandBuffer, !useGeometryShader);
+        }
+        if (frameInfo.renderer != nullptr)
+        {
+            frameInfo.renderer->endGpuScope(frameInfo.commandBuffer, gpuScope);
         }
     }
 
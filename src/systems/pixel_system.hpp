@@ -1,7 +1,9 @@
 
 #pragma once
 
+#include "../base/pai_buffer.hpp"
 #include "../base/pai_camera.hpp"
+#include "../base/pai_descriptors.hpp"
 #include "../base/pai_device.hpp"
 #include "../pai_frame_info.hpp"
 #include "../pai_game_object.hpp"
@@ -9,6 +11,8 @@
 
 // std
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace pai
@@ -16,8 +20,13 @@ namespace pai
     class PixelSystem
     {
     public:
+        // useGeometryShader selects the old point-expansion path for A/B comparison;
+        // the default draws one instanced quad per cell
         PixelSystem(
-            PaiDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+            PaiDevice &device,
+            VkRenderPass renderPass,
+            VkDescriptorSetLayout globalSetLayout,
+            bool useGeometryShader = false);
         ~PixelSystem();
 
         PixelSystem(const PixelSystem &) = delete;
@@ -25,13 +34,45 @@ namespace pai
 
          void render(FrameInfo &frameInfo);
 
+        // Batched path: every grid's cells live in one shared vertex buffer, per-grid
+        // color/size sit in a draw-data buffer indexed by gl_DrawID, and a single
+        // vkCmdDrawIndirect submits all grids. updateBatch records the per-grid
+        // copies into the shared buffer and must run outside the render pass.
+        void updateBatch(FrameInfo &frameInfo);
+        void renderBatched(FrameInfo &frameInfo);
+
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
         void createPipeline(VkRenderPass renderPass);
+        void createBatchPipeline(VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        void rebuildBatch(FrameInfo &frameInfo);
+        // per-grid pipeline with the cell size baked in as a specialization
+        // constant, cached on the constant block so equal grids share one variant
+        PaiPipeline &pipelineVariantFor(PaiPixel *pixel);
+
+        struct BatchEntry
+        {
+            PaiPixel *pixel;
+            VkDeviceSize size;   // bytes of vertex data
+            VkDeviceSize offset; // into the shared vertex buffer
+        };
 
         PaiDevice &paiDevice;
 
         std::unique_ptr<PaiPipeline> paiPipeline;
         VkPipelineLayout pipelineLayout;
+        VkRenderPass renderPass;
+        bool useGeometryShader;
+        std::unordered_map<std::string, std::unique_ptr<PaiPipeline>> pipelineVariants;
+
+        std::unique_ptr<PaiPipeline> batchPipeline;
+        VkPipelineLayout batchPipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<PaiDescriptorPool> batchDescriptorPool;
+        std::unique_ptr<PaiDescriptorSetLayout> batchSetLayout;
+        VkDescriptorSet batchDescriptorSet = VK_NULL_HANDLE;
+        std::unique_ptr<PaiBuffer> batchVertexBuffer;
+        std::unique_ptr<PaiBuffer> drawDataBuffer; // PixelDrawData per grid
+        std::unique_ptr<PaiBuffer> indirectBuffer; // VkDrawIndirectCommand per grid
+        std::vector<BatchEntry> batchEntries;
     };
 }
\ No newline at end of file
@@ -59,16 +59,17 @@ namespace pai
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-        PipelineConfigInfo pipelineConfig{};
-        PaiPipeline::defaultPipelineConfigInfo(pipelineConfig);
-        PaiPipeline::enableAlphaBlending(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
+        auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+        PaiPipeline::defaultPipelineConfigInfo(*pipelineConfig);
+        PaiPipeline::enableAlphaBlending(*pipelineConfig);
+        pipelineConfig->renderPass = renderPass;
+        pipelineConfig->pipelineLayout = pipelineLayout;
         paiPipeline = std::make_unique<PaiPipeline>(
             paiDevice,
             "shaders/simple_shader.vert.spv",
             "shaders/simple_shader.frag.spv",
-            pipelineConfig);
+            std::move(pipelineConfig));
+        paiPipeline->watchForReload();
     }
 
     void SimpleRenderSystem::render(
@@ -76,6 +77,7 @@ namespace pai
     {
         paiPipeline->bind(frameInfo.commandBuffer);
 
+        uint32_t dynamicOffsets[] = {frameInfo.globalUboOffset, frameInfo.agentGridOffset};
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -83,17 +85,14 @@ namespace pai
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            2,
+            dynamicOffsets);
 
-        for (auto &kv : frameInfo.gameObjects)
+        for (auto &renderable : frameInfo.registry.modelRenderables())
         {
-            auto &obj = kv.second;
-            if (obj.model == nullptr)
-                continue;
             SimplePushConstantData push{};
-            push.modelMatrix = obj.transform.mat4();
-            push.normalMatrix = obj.transform.normalMatrix();
+            push.modelMatrix = renderable.transform->mat4();
+            push.normalMatrix = renderable.transform->normalMatrix();
 
             vkCmdPushConstants(
                 frameInfo.commandBuffer,
@@ -102,8 +101,8 @@ namespace pai
                 0,
                 sizeof(SimplePushConstantData),
                 &push);
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            renderable.model->bind(frameInfo.commandBuffer);
+            renderable.model->draw(frameInfo.commandBuffer);
         }
     }
 